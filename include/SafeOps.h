@@ -3,6 +3,8 @@
 
 #include <stddef.h>  // For size_t
 #include <stdbool.h> // For bool
+#include <stdint.h>  // For fixed-width integer types
+#include <stdarg.h>  // For va_list
 #include <stdio.h>
 #include <wchar.h>   // For wide string support
 
@@ -16,7 +18,8 @@ typedef enum {
     SAFEOPS_ERR_ALLOCATION_FAILED,
     SAFEOPS_ERR_FILE_ACCESS,
     SAFEOPS_ERR_OVERLAP,
-    SAFEOPS_ERR_UNKNOWN
+    SAFEOPS_ERR_UNKNOWN,
+    SAFEOPS_ERR_INVALID_ENCODING  /* Malformed UTF-8/UTF-16 or invalid code point */
 } SafeOpsError;
 
 /* Error logging callback type */
@@ -35,6 +38,10 @@ bool SafeFreeTyped(void **ptrRef, size_t size);   /* With secure clearing */
 /* Generic version of SafeFree for typed pointers */
 #define SAFE_FREE(type, ptr) SafeFreeTyped((void**)ptr, sizeof(type))
 
+/* Constant-time equality for secrets (tokens, MACs) - runtime depends only on length */
+bool SafeMemEqualCT(const void *a, const void *b, size_t len);
+bool SafeStrEqualCT(const char *a, const char *b, size_t maxLen);
+
 /* Enhanced string operations - NULL terminated strings */
 bool SafeStrCopy(char *dest, size_t destSize, const char *src);
 bool SafeStrCat(char *dest, size_t destSize, const char *src);
@@ -49,6 +56,113 @@ bool SafeStrReplace(char *str, size_t strSize,
                     const char *oldStr, const char *newStr,
                     size_t *outLen);
 
+/* Non-mutating splitter: tokens are {offset, len} slices of buf. Every
+   delimiter ends a token, so "a,,b" gives "a", "" and "b" unless
+   SAFE_SPLIT_SKIP_EMPTY is set. The iterator borrows buf and delim. */
+typedef enum {
+    SAFE_SPLIT_CHAR       = 0,       /* delim is a single byte */
+    SAFE_SPLIT_CHARSET    = 1,       /* any byte of delim[0..delimLen) */
+    SAFE_SPLIT_STRING     = 2,       /* the whole delim sequence */
+    SAFE_SPLIT_SKIP_EMPTY = 1 << 2   /* Combine with a mode to drop empty tokens */
+} SafeSplitFlags;
+
+typedef struct {
+    size_t offset;
+    size_t len;
+} SafeStrToken;
+
+typedef struct {
+    const char *buf;
+    size_t len;
+    size_t pos;
+    const char *delim;
+    size_t delimLen;
+    unsigned int flags;
+    bool done;
+    bool asciiSet;
+    unsigned char setBitmap[32];   /* Charset mode: membership of every byte value */
+    unsigned char setNibbles[16];  /* Charset mode: SIMD lookup table */
+} SafeStrSplitter;
+
+bool SafeStrSplitInit(SafeStrSplitter *it, const char *buf, size_t len,
+                      const char *delim, size_t delimLen, unsigned int flags);
+bool SafeStrSplitNext(SafeStrSplitter *it, SafeStrToken *outToken);  /* false when exhausted */
+
+/* Hex, base64 and base32 with strict decoding. Encoders write a
+   NUL-terminated string and follow the UTF converter conventions (dest NULL
+   only sizes, a short dest is left empty). Decoders write raw bytes, no
+   terminator; dest NULL validates and sizes. On SAFEOPS_ERR_INVALID_ENCODING
+   *outLen is the offset of the offending character (srcLen for a bad length)
+   and dest's contents are unspecified. Hex encodes lowercase and decodes
+   either case. Base64 and base32 reject whitespace, misplaced or missing
+   padding and non-zero trailing bits. Hex and base64 use AVX2 when the CPU
+   has it. */
+typedef enum {
+    SAFE_BASE64_DEFAULT = 0,       /* RFC 4648 alphabet, '=' padding */
+    SAFE_BASE64_URL     = 1 << 0,  /* '-' and '_' in place of '+' and '/' */
+    SAFE_BASE64_NO_PAD  = 1 << 1   /* Omit padding; decoding then rejects '=' */
+} SafeBase64Flags;
+
+size_t SafeHexEncodedLen(size_t srcLen);  /* Excluding the NUL; SIZE_MAX on overflow */
+bool SafeHexEncode(char *dest, size_t destSize, const void *src, size_t srcLen, size_t *outLen);
+bool SafeHexDecode(void *dest, size_t destSize, const char *src, size_t srcLen, size_t *outLen);
+size_t SafeBase64EncodedLen(size_t srcLen, unsigned int flags);
+size_t SafeBase64DecodedLen(const char *src, size_t srcLen, unsigned int flags);  /* Exact for valid input */
+bool SafeBase64Encode(char *dest, size_t destSize, const void *src, size_t srcLen,
+                      unsigned int flags, size_t *outLen);
+bool SafeBase64Decode(void *dest, size_t destSize, const char *src, size_t srcLen,
+                      unsigned int flags, size_t *outLen);
+
+typedef enum {
+    SAFE_BASE32_DEFAULT = 0,       /* RFC 4648 alphabet, uppercase only, '=' padding */
+    SAFE_BASE32_NO_PAD  = 1 << 1
+} SafeBase32Flags;
+
+size_t SafeBase32EncodedLen(size_t srcLen, unsigned int flags);
+size_t SafeBase32DecodedLen(const char *src, size_t srcLen, unsigned int flags);  /* Exact for valid input */
+bool SafeBase32Encode(char *dest, size_t destSize, const void *src, size_t srcLen,
+                      unsigned int flags, size_t *outLen);
+bool SafeBase32Decode(void *dest, size_t destSize, const char *src, size_t srcLen,
+                      unsigned int flags, size_t *outLen);
+
+/* Escaping for embedding untrusted text. Output is NUL-terminated and
+   follows the encoder conventions: dest NULL only sizes, a short dest is left
+   empty and *outLen is the length needed. JSON escapes '"', '\\' and control
+   characters (bytes >= 0x80 pass through, so validate UTF-8 first); HTML
+   escapes & < > " '; URL percent-encodes everything but RFC 3986 unreserved
+   characters. */
+bool SafeEscapeJson(char *dest, size_t destSize, const char *src, size_t srcLen, size_t *outLen);
+bool SafeEscapeHtml(char *dest, size_t destSize, const char *src, size_t srcLen, size_t *outLen);
+bool SafeEscapeUrl(char *dest, size_t destSize, const char *src, size_t srcLen, size_t *outLen);
+
+/* String interning: one stable, NUL-terminated copy of each distinct byte
+   string, so interned strings compare equal exactly when their pointers do.
+   Ids are dense, assigned from 0 in insertion order. Copies live in an arena
+   that is freed only by SafeStrInternDestroy. With SAFE_INTERN_CONCURRENT
+   the table is thread-safe: lookups take a shared lock and only new strings
+   take it exclusively. */
+typedef struct SafeInternTable SafeInternTable;
+
+typedef enum {
+    SAFE_INTERN_DEFAULT    = 0,       /* Single-threaded, no locking */
+    SAFE_INTERN_CONCURRENT = 1 << 0   /* Reader-writer lock around the table */
+} SafeInternFlags;
+
+SafeInternTable* SafeStrInternCreate(size_t expectedCount, unsigned int flags);
+const char* SafeStrIntern(SafeInternTable *table, const char *str, size_t len, uint32_t *outId);  /* outId optional */
+const char* SafeStrInternFind(SafeInternTable *table, const char *str, size_t len, uint32_t *outId);  /* NULL if absent */
+const char* SafeStrInternGet(SafeInternTable *table, uint32_t id, size_t *outLen);
+size_t SafeStrInternCount(SafeInternTable *table);
+void SafeStrInternDestroy(SafeInternTable **table);
+
+/* Bounded comparison operations - *outResult is -1, 0 or 1 */
+bool SafeMemCompare(const void *a, size_t aSize, const void *b, size_t bSize, int *outResult);
+bool SafeMemEqual(const void *a, size_t aSize, const void *b, size_t bSize);
+bool SafeStrCompare(const char *a, const char *b, size_t maxLen, int *outResult);
+bool SafeStrCaseCompare(const char *a, const char *b, size_t maxLen, int *outResult);  /* ASCII only */
+bool SafeMemCaseCompare(const void *a, size_t aSize, const void *b, size_t bSize, int *outResult);
+bool SafeMemCaseEqual(const void *a, size_t aSize, const void *b, size_t bSize);
+
 /* Wide string operations (wchar_t) */
 bool SafeWStrCopy(wchar_t *dest, size_t destSize, const wchar_t *src);
 bool SafeWStrCat(wchar_t *dest, size_t destSize, const wchar_t *src);
@@ -56,6 +170,24 @@ bool SafeWStrLen(const wchar_t *str, size_t maxLen, size_t *outLen);
 bool SafeWStrNCopy(wchar_t *dest, size_t destSize, const wchar_t *src, size_t count);
 bool SafeWStrNCat(wchar_t *dest, size_t destSize, const wchar_t *src, size_t count);
 
+/* Strict, locale-independent UTF-8 <-> UTF-16 / UTF-32 / wchar_t conversion.
+   Lengths are in code units and exclude the terminator. With dest NULL only
+   *outLen (the exact size needed) is computed; otherwise dest is written and
+   NUL-terminated. On SAFEOPS_ERR_INVALID_ENCODING *outLen is the offset of the
+   first bad sequence in src; on SAFEOPS_ERR_OUT_OF_BOUNDS it is the size that
+   was needed. dest holds an empty string after any failure. */
+bool SafeUtf8ToUtf16(const char *src, size_t srcLen, uint16_t *dest, size_t destSize, size_t *outLen);
+bool SafeUtf8ToUtf32(const char *src, size_t srcLen, uint32_t *dest, size_t destSize, size_t *outLen);
+bool SafeUtf8ToWide(const char *src, size_t srcLen, wchar_t *dest, size_t destSize, size_t *outLen);
+bool SafeUtf16ToUtf8(const uint16_t *src, size_t srcLen, char *dest, size_t destSize, size_t *outLen);
+bool SafeUtf32ToUtf8(const uint32_t *src, size_t srcLen, char *dest, size_t destSize, size_t *outLen);
+bool SafeWideToUtf8(const wchar_t *src, size_t srcLen, char *dest, size_t destSize, size_t *outLen);
+
+/* UTF-8 well-formedness check (same rules as the converters). On failure
+   *outErrorOffset, if not NULL, is the offset of the first bad sequence. */
+bool SafeUtf8Validate(const char *buf, size_t len, size_t *outErrorOffset);
+bool SafeUtf8CountCodePoints(const char *buf, size_t len, size_t *outCount, size_t *outErrorOffset);
+
 
 /* Memory operations */
 bool SafeMemCopy(void *dest, size_t destSize, const void *src, size_t srcSize);
@@ -80,9 +212,136 @@ bool SafeMulInt(int a, int b, int *result);
 bool SafeDivInt(int a, int b, int *result);
 bool SafeCastLongLongToInt(long long val, int *out);
 
-/* Enhanced printf with format validation */
-int SafePrintf(const char *format, ...);
-int SafeSnprintf(char *str, size_t size, const char *format, ...);
+/* Locale-independent parsing of an entire (ptr, len) span - no whitespace, no
+   trailing characters. Syntax errors give SAFEOPS_ERR_INVALID_PARAM, values out
+   of range SAFEOPS_ERR_OVERFLOW. Doubles accept [+-]digits[.digits][e[+-]digits]
+   plus inf/infinity/nan. */
+bool SafeParseInt32(const char *str, size_t len, int32_t *out);
+bool SafeParseInt64(const char *str, size_t len, int64_t *out);
+bool SafeParseUInt64(const char *str, size_t len, uint64_t *out);
+bool SafeParseDouble(const char *str, size_t len, double *out);
+
+/* Enhanced printf with format validation: %n, positional arguments and
+   malformed conversions are rejected with SAFEOPS_ERR_INVALID_PARAM.
+   SafeSnprintf returns the length written, or -1 with SAFEOPS_ERR_OUT_OF_BOUNDS
+   and an empty str when the output would be truncated. */
+#if defined(__GNUC__) || defined(__clang__)
+#define SAFEOPS_PRINTF_FMT(formatIndex, firstArg) __attribute__((format(printf, formatIndex, firstArg)))
+#else
+#define SAFEOPS_PRINTF_FMT(formatIndex, firstArg)
+#endif
+
+int SafePrintf(const char *format, ...) SAFEOPS_PRINTF_FMT(1, 2);
+int SafeSnprintf(char *str, size_t size, const char *format, ...) SAFEOPS_PRINTF_FMT(3, 4);
+
+/* Buffered mode for SafePrintf/SafePrintfStr (POSIX). Each thread formats into
+   its own buffer and hands complete lines to write(2) in batches: when the
+   buffer fills, when its oldest complete line is flushIntervalMs old (a
+   background thread enforces this for threads that stop printing), on
+   SafePrintfFlush and at thread exit or exit().
+   Batches are written whole under one lock, so lines from different threads
+   never interleave. Output bypasses stdio, so do not interleave it with printf
+   on stdout while enabled. bufferSize 0 selects 64 KiB and applies to threads
+   that print for the first time afterwards; flushIntervalMs 0 selects 100 ms.
+   Disabling flushes every thread's buffer. */
+bool SafePrintfSetBuffered(bool enabled, size_t bufferSize, unsigned int flushIntervalMs);
+bool SafePrintfFlush(void);     /* Calling thread, partial line included */
+bool SafePrintfFlushAll(void);  /* Every thread */
+
+/* Non-variadic equivalents of SafeSnprintf(str, size, "%lld" / "%llu" /
+   "%llx" / "%s", value) and SafePrintf("%s", text), with the same results
+   (a NULL string prints as "(null)") */
+int SafeSnprintfInt(char *str, size_t size, long long value);
+int SafeSnprintfUInt(char *str, size_t size, unsigned long long value);
+int SafeSnprintfHex(char *str, size_t size, unsigned long long value);
+int SafeSnprintfStr(char *str, size_t size, const char *value);
+int SafePrintfStr(const char *text);
+
+/* A format validated and split into literal runs and conversions once, for
+   formats used over and over. Running it has SafeSnprintf's semantics; plain
+   %d/%i/%u/%x/%s/%c (any integer length but h/hh) skip printf entirely. */
+typedef struct SafeFormat SafeFormat;
+
+SafeFormat* SafeFormatCompile(const char *format);
+int SafeFormatRun(const SafeFormat *format, char *buf, size_t size, ...);
+int SafeFormatRunV(const SafeFormat *format, char *buf, size_t size, va_list args);
+void SafeFormatFree(SafeFormat **format);
+
+/* With GCC or Clang, SafePrintf and SafeSnprintf calls whose format is a
+   literal with no conversions, or exactly one plain %d %i %u %x %s (with
+   l, ll or z as applicable) and an argument whose promoted type is exactly
+   the one the conversion expects (so a short for %d qualifies), compile to
+   the non-variadic functions above. Everything else calls the real function
+   and keeps the -Wformat checks. Define SAFEOPS_NO_FORMAT_DISPATCH to turn
+   this off. */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(__cplusplus) && !defined(SAFEOPS_NO_FORMAT_DISPATCH)
+
+#define SAFEOPS_FMT_FIRST_(format, ...) format
+#define SAFEOPS_FMT_SECOND_(format, arg, ...) arg
+
+#define SAFEOPS_FMT_IS_(format, literal) \
+    (__builtin_constant_p(format) && __builtin_strcmp((format), literal) == 0)
+#define SAFEOPS_FMT_NO_CONVERSIONS_(format) \
+    (__builtin_constant_p(format) && __builtin_strchr((format), '%') == 0)
+/* ?: applies the same decay and promotions as passing the argument to printf */
+#define SAFEOPS_ARG_IS_(arg, type) __builtin_types_compatible_p(__typeof__(1 ? (arg) : (arg)), type)
+
+#define SAFEOPS_FMT_SIGNED_(format, arg) \
+    (((SAFEOPS_FMT_IS_(format, "%d") || SAFEOPS_FMT_IS_(format, "%i")) && SAFEOPS_ARG_IS_(arg, int)) || \
+     (SAFEOPS_FMT_IS_(format, "%ld") && SAFEOPS_ARG_IS_(arg, long)) || \
+     (SAFEOPS_FMT_IS_(format, "%lld") && SAFEOPS_ARG_IS_(arg, long long)))
+#define SAFEOPS_FMT_UNSIGNED_(format, arg, conv) \
+    ((SAFEOPS_FMT_IS_(format, "%" conv) && SAFEOPS_ARG_IS_(arg, unsigned int)) || \
+     (SAFEOPS_FMT_IS_(format, "%l" conv) && SAFEOPS_ARG_IS_(arg, unsigned long)) || \
+     (SAFEOPS_FMT_IS_(format, "%ll" conv) && SAFEOPS_ARG_IS_(arg, unsigned long long)) || \
+     (SAFEOPS_FMT_IS_(format, "%z" conv) && SAFEOPS_ARG_IS_(arg, size_t)))
+#define SAFEOPS_FMT_STRING_(format, arg) \
+    (SAFEOPS_FMT_IS_(format, "%s") && (SAFEOPS_ARG_IS_(arg, char *) || SAFEOPS_ARG_IS_(arg, const char *)))
+
+/* Only the branch whose type test passed ever sees the real argument */
+#define SAFEOPS_ARG_AS_SIGNED_(arg) \
+    __builtin_choose_expr(SAFEOPS_ARG_IS_(arg, int) || SAFEOPS_ARG_IS_(arg, long) || \
+                          SAFEOPS_ARG_IS_(arg, long long), (arg), 0LL)
+#define SAFEOPS_ARG_AS_UNSIGNED_(arg) \
+    __builtin_choose_expr(SAFEOPS_ARG_IS_(arg, unsigned int) || SAFEOPS_ARG_IS_(arg, unsigned long) || \
+                          SAFEOPS_ARG_IS_(arg, unsigned long long), (arg), 0ULL)
+#define SAFEOPS_ARG_AS_STRING_(arg) \
+    __builtin_choose_expr(SAFEOPS_ARG_IS_(arg, char *) || SAFEOPS_ARG_IS_(arg, const char *), \
+                          (arg), (const char *)0)
+
+#define SAFEOPS_SNPRINTF_DISPATCH_(str, size, format, arg, ...) \
+    (SAFEOPS_FMT_NO_CONVERSIONS_(format) ? SafeSnprintfStr((str), (size), (format)) : \
+     SAFEOPS_FMT_SIGNED_(format, arg) ? SafeSnprintfInt((str), (size), SAFEOPS_ARG_AS_SIGNED_(arg)) : \
+     SAFEOPS_FMT_UNSIGNED_(format, arg, "u") ? SafeSnprintfUInt((str), (size), SAFEOPS_ARG_AS_UNSIGNED_(arg)) : \
+     SAFEOPS_FMT_UNSIGNED_(format, arg, "x") ? SafeSnprintfHex((str), (size), SAFEOPS_ARG_AS_UNSIGNED_(arg)) : \
+     SAFEOPS_FMT_STRING_(format, arg) ? SafeSnprintfStr((str), (size), SAFEOPS_ARG_AS_STRING_(arg)) : \
+     (SafeSnprintf)((str), (size), __VA_ARGS__))
+
+#define SAFEOPS_PRINTF_DISPATCH_(format, arg, ...) \
+    (SAFEOPS_FMT_NO_CONVERSIONS_(format) ? SafePrintfStr(format) : \
+     SAFEOPS_FMT_STRING_(format, arg) ? SafePrintfStr(SAFEOPS_ARG_AS_STRING_(arg)) : \
+     (SafePrintf)(__VA_ARGS__))
+
+/* The trailing 0s stand in for a missing argument; they are never used */
+#define SafeSnprintf(str, size, ...) \
+    SAFEOPS_SNPRINTF_DISPATCH_(str, size, SAFEOPS_FMT_FIRST_(__VA_ARGS__, 0), \
+                               SAFEOPS_FMT_SECOND_(__VA_ARGS__, 0, 0), __VA_ARGS__)
+#define SafePrintf(...) \
+    SAFEOPS_PRINTF_DISPATCH_(SAFEOPS_FMT_FIRST_(__VA_ARGS__, 0), \
+                             SAFEOPS_FMT_SECOND_(__VA_ARGS__, 0, 0), __VA_ARGS__)
+
+#endif
+
+/* Number to text without printf. Same buffer conventions as the UTF
+   converters: *outWritten is the length excluding the terminator, dest NULL
+   only computes it, and a too small dest is left empty with
+   SAFEOPS_ERR_OUT_OF_BOUNDS. Hex is lowercase without a prefix. Doubles print
+   the shortest digits that read back to the same value (inf/-inf/nan for
+   non-finite values). */
+bool SafeFmtInt(char *dest, size_t destSize, int64_t value, size_t *outWritten);
+bool SafeFmtUInt(char *dest, size_t destSize, uint64_t value, size_t *outWritten);
+bool SafeFmtHex(char *dest, size_t destSize, uint64_t value, size_t *outWritten);
+bool SafeFmtDouble(char *dest, size_t destSize, double value, size_t *outWritten);
 
 /* File operations with enhanced security notes */
 typedef struct {
@@ -94,6 +353,177 @@ typedef struct {
 
 FILE* SafeFOpen(const char *filePath, const char *mode, const SafeFileOpts *opts);
 bool SafeFClose(FILE **fp);  /* Secure close with NULL assignment */
+bool SafeSecureUnlink(const char *filePath, const SafeFileOpts *opts);  /* Wipes first if opts->secureDelete */
+int SafeFOpenFd(const char *filePath, const char *mode, const SafeFileOpts *opts);  /* -1 on failure */
+
+/* Extended open options: SafeFileOpts plus access-pattern hints. Versioned
+   by structSize so fields can be appended without breaking binaries built
+   against older headers - always start from SAFE_FILE_OPTS_EX_INIT. */
+typedef enum {
+    SAFE_ADVICE_NORMAL = 0,
+    SAFE_ADVICE_SEQUENTIAL,
+    SAFE_ADVICE_RANDOM,
+    SAFE_ADVICE_NOREUSE,
+    SAFE_ADVICE_WILLNEED,
+    SAFE_ADVICE_DONTNEED
+} SafeFileAdvice;
+
+typedef struct {
+    size_t structSize;                   /* sizeof(SafeFileOptsEx) */
+    SafeFileOpts base;                   /* Security options, as for SafeFOpen */
+    bool directIO;                       /* Bypass the page cache (SafeFOpenFdEx only) */
+    bool noAtime;                        /* Skip atime updates where permitted */
+    SafeFileAdvice advice;               /* posix_fadvise for the whole file */
+    unsigned long long readaheadBytes;   /* Prefetch this much from offset 0 (read modes) */
+    unsigned long long preallocBytes;    /* Reserve space past the end (write modes) */
+} SafeFileOptsEx;
+
+#define SAFE_FILE_OPTS_EX_INIT \
+    { sizeof(SafeFileOptsEx), { false, true, 0644, false }, false, false, SAFE_ADVICE_NORMAL, 0, 0 }
+
+FILE* SafeFOpenEx(const char *filePath, const char *mode, const SafeFileOptsEx *opts);
+int SafeFOpenFdEx(const char *filePath, const char *mode, const SafeFileOptsEx *opts);
+
+/* Open relPath confined beneath dirFd (POSIX only). Absolute paths and ".."
+   escapes are rejected; symlinks are refused unless opts->followSymlinks. */
+FILE* SafeFOpenAt(int dirFd, const char *relPath, const char *mode, const SafeFileOpts *opts);
+
+/* Memory-mapped, read-only file access (same open checks as SafeFOpen) */
+typedef struct {
+    const void *data;  /* Start of the mapping, NULL for empty files */
+    size_t size;       /* File size in bytes */
+} SafeFileView;
+
+typedef enum {
+    SAFE_MAP_NORMAL     = 0,
+    SAFE_MAP_SEQUENTIAL = 1 << 0,  /* Aggressive readahead, early page reclaim */
+    SAFE_MAP_WILLNEED   = 1 << 1,  /* Start paging the file in immediately */
+    SAFE_MAP_HUGEPAGE   = 1 << 2   /* Back the mapping with huge pages where supported */
+} SafeMapHint;
+
+bool SafeFMap(const char *filePath, const SafeFileOpts *opts, unsigned int hints, SafeFileView *outView);
+bool SafeFUnmap(SafeFileView *view);
+
+/* Borrowed (pointer, length) view into memory owned elsewhere; not NUL-terminated */
+typedef struct {
+    const char *ptr;
+    size_t len;
+} SafeStrView;
+
+/* Line-by-line reading without copying lines out. Views point into the
+   reader's buffer (or the mapping) and stay valid until the next call.
+   The '\n' is not included; the descriptor is not owned by the reader.
+   bufferSize 0 selects 1 MiB, maxLineLen 0 selects 64 KiB. A longer line
+   fails with SAFEOPS_ERR_OUT_OF_BOUNDS and is skipped, so the next call
+   returns the line after it. */
+typedef struct SafeLineReader SafeLineReader;
+
+SafeLineReader* SafeLineReaderOpenFd(int fd, size_t bufferSize, size_t maxLineLen);
+SafeLineReader* SafeLineReaderOpenView(const SafeFileView *view, size_t maxLineLen);
+bool SafeLineReaderNext(SafeLineReader *reader, SafeStrView *outLine, bool *outEof);
+void SafeLineReaderClose(SafeLineReader **reader);
+
+/* Large-buffer writer over a SafeFOpen-validated descriptor. No stdio locking:
+   use one writer per thread. bufferSize 0 selects 1 MiB; preallocSize reserves
+   disk blocks up front without changing the file size (0 to skip). */
+typedef struct SafeFileWriter SafeFileWriter;
+
+SafeFileWriter* SafeFileWriterOpen(const char *filePath, const char *mode, const SafeFileOpts *opts,
+                                   size_t bufferSize, size_t preallocSize);
+bool SafeFileWriterWrite(SafeFileWriter *writer, const void *data, size_t size);
+bool SafeFileWriterFlush(SafeFileWriter *writer);
+bool SafeFileWriterClose(SafeFileWriter **writer);  /* Flushes, closes and NULLs */
+
+/* Atomic file replacement: buffered writes go to a temp file in the target's
+   directory, which is fsync'd and renamed over the target on commit */
+typedef struct SafeAtomicWriter SafeAtomicWriter;
+
+SafeAtomicWriter* SafeAtomicWriterOpen(const char *filePath, const SafeFileOpts *opts);
+bool SafeAtomicWriterWrite(SafeAtomicWriter *writer, const void *data, size_t size);
+bool SafeAtomicWriterCommit(SafeAtomicWriter **writer);  /* Releases the writer either way */
+void SafeAtomicWriterAbort(SafeAtomicWriter **writer);   /* Discards, target untouched */
+
+/* Copy a file, applying the SafeFOpen checks to both ends. Tries reflink
+   (FICLONE), copy_file_range and sendfile before a buffered loop. */
+bool SafeFileCopy(const char *srcPath, const char *dstPath, const SafeFileOpts *opts);
+
+/* Cache of validated read-only descriptors keyed by (dirFd, path). A hit costs
+   one stat to confirm inode, size and mtime are unchanged. Idle descriptors
+   are closed LRU-first to stay within maxFds. dirFd may be AT_FDCWD; any
+   other directory confines paths as SafeFOpenAt does. Thread-safe. */
+typedef struct SafeFileCache SafeFileCache;
+typedef struct SafeCachedFile SafeCachedFile;
+
+SafeFileCache* SafeFileCacheCreate(size_t maxFds, const SafeFileOpts *opts);
+SafeCachedFile* SafeFileCacheAcquire(SafeFileCache *cache, int dirFd, const char *relPath);
+void SafeFileCacheRelease(SafeFileCache *cache, SafeCachedFile **file);
+int SafeCachedFileFd(const SafeCachedFile *file);
+unsigned long long SafeCachedFileSize(const SafeCachedFile *file);
+bool SafeCachedFileRead(const SafeCachedFile *file, void *buf, size_t size,
+                        unsigned long long offset, size_t *outRead);
+void SafeFileCacheDestroy(SafeFileCache **cache);  /* Release all handles first */
+
+/* Recursive directory walk. Each directory is opened with openat relative to
+   its parent's descriptor and read in large batches; entry types come from
+   d_type, so most entries cost no stat. Symlinks are reported, not followed,
+   unless SAFE_WALK_FOLLOW_SYMLINKS is set. With threads > 1 subdirectories are
+   fanned out to workers and the callback runs concurrently. Returns false if
+   any directory could not be read; the walk still covers the rest. */
+typedef enum {
+    SAFE_ENTRY_FILE    = 0,
+    SAFE_ENTRY_DIR     = 1,
+    SAFE_ENTRY_SYMLINK = 2,
+    SAFE_ENTRY_OTHER   = 3   /* Devices, FIFOs, sockets */
+} SafeDirEntryType;
+
+typedef enum {
+    SAFE_WALK_CONTINUE = 0,
+    SAFE_WALK_SKIP     = 1,  /* Do not descend into this directory */
+    SAFE_WALK_STOP     = 2   /* End the whole walk */
+} SafeWalkAction;
+
+typedef enum {
+    SAFE_WALK_DEFAULT         = 0,
+    SAFE_WALK_FOLLOW_SYMLINKS = 1 << 0,  /* Each directory is still read only once */
+    SAFE_WALK_SAME_DEVICE     = 1 << 1   /* Do not cross mount points */
+} SafeWalkFlags;
+
+typedef struct {
+    int dirFd;              /* Containing directory, e.g. for SafeFOpenAt(dirFd, name, ...) */
+    const char *name;
+    const char *relPath;    /* Relative to the walk root */
+    size_t relPathLen;
+    SafeDirEntryType type;
+    unsigned int depth;     /* 0 for entries directly in the root */
+} SafeDirEntry;
+
+/* The entry and its strings are only valid during the call */
+typedef SafeWalkAction (*SafeDirWalkCallback)(void *userData, const SafeDirEntry *entry);
+
+bool SafeDirWalk(const char *rootPath, unsigned int flags, unsigned int threads,
+                 SafeDirWalkCallback callback, void *userData);
+
+/* Asynchronous file I/O on descriptors from SafeFOpenFd. Uses io_uring on
+   Linux and falls back to a small worker-thread pool doing pread/pwrite.
+   Requests are batched until SafeAsyncSubmit; callbacks run inside
+   SafeAsyncPoll on the polling thread. result is bytes transferred or -errno. */
+typedef struct SafeAsyncIO SafeAsyncIO;
+typedef void (*SafeAsyncCallback)(void *userData, long long result);
+
+typedef enum {
+    SAFE_ASYNC_DEFAULT       = 0,
+    SAFE_ASYNC_FORCE_THREADS = 1 << 0  /* Skip io_uring even where available */
+} SafeAsyncFlags;
+
+SafeAsyncIO* SafeAsyncCreate(unsigned int queueDepth, unsigned int flags);
+bool SafeAsyncRead(SafeAsyncIO *aio, int fd, void *buf, size_t size, unsigned long long offset,
+                   SafeAsyncCallback callback, void *userData);
+bool SafeAsyncWrite(SafeAsyncIO *aio, int fd, const void *buf, size_t size, unsigned long long offset,
+                    SafeAsyncCallback callback, void *userData);
+bool SafeAsyncSubmit(SafeAsyncIO *aio);  /* On a full ring, poll and submit again */
+int SafeAsyncPoll(SafeAsyncIO *aio, unsigned int minComplete);  /* Completions reaped, -1 on error */
+bool SafeAsyncUsesIoUring(const SafeAsyncIO *aio);
+void SafeAsyncDestroy(SafeAsyncIO **aio);  /* Waits for submitted requests */
 
 /* Validation helpers */
 bool IsValidPointer(const void *ptr);
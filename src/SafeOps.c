@@ -1,16 +1,30 @@
 /* SafeOps.c - Cross-platform implementation of safe operations */
 
+/* Expose POSIX/Linux file APIs (fdopen, mmap, madvise, ...) under strict C99 */
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#define SAFEOPS_NO_FORMAT_DISPATCH  /* Define the real SafePrintf/SafeSnprintf */
 #include "../include/SafeOps.h"
 #include <errno.h>
+#include <float.h>
 #include <limits.h>
+#include <locale.h>
+#include <math.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /* Platform-specific includes */
 #ifdef _WIN32
 #include <sys/stat.h>
 #include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#include <share.h>
 #define THREAD_LOCAL __declspec(thread)
 #define S_ISREG(m) (((m) & S_IFMT) == S_IFREG)
 #else
@@ -18,10 +32,56 @@
 #define THREAD_LOCAL __thread
 #include <sys/types.h>
     #include <sys/stat.h>
+    #include <sys/mman.h>
+    #include <sys/uio.h>
     #include <fcntl.h>
+    #include <dirent.h>
     #if defined(__unix__) || defined(__APPLE__)
         #include <unistd.h>
     #endif
+    #ifdef __linux__
+        #include <sys/ioctl.h>
+        #include <sys/sendfile.h>
+        #include <sys/syscall.h>
+        #ifndef FICLONE
+            #define FICLONE _IOW(0x94, 9, int)
+        #endif
+    #endif
+#endif
+
+/* Linux io_uring (raw syscalls, no liburing dependency) */
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define SAFEOPS_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+/* Linux openat2 (5.6+) for in-kernel RESOLVE_BENEATH path checks */
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/openat2.h>)
+#include <linux/openat2.h>
+#include <sys/syscall.h>
+#ifdef __NR_openat2
+#define SAFEOPS_HAVE_OPENAT2 1
+#endif
+#endif
+#endif
+
+/* SIMD support - SSE2 is part of the x86-64 baseline, so no runtime check needed */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SAFEOPS_HAVE_SSE2 1
+#endif
+
+/* Wider x86 kernels are compiled per function and selected at runtime */
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SAFEOPS_HAVE_X86_DISPATCH 1
+#define SAFEOPS_TARGET(isa) __attribute__((target(isa)))
 #endif
 
 /* Error handling macro */
@@ -130,6 +190,154 @@ bool SafeFreeTyped(void **ptrRef, size_t size)
     return true;
 }
 
+/* Length of str, scanning at most maxLen bytes (returns maxLen if no NUL found) */
+static size_t BoundedStrLen(const char *str, size_t maxLen) {
+    const char *nul = (const char *)memchr(str, '\0', maxLen);
+    return nul ? (size_t)(nul - str) : maxLen;
+}
+
+static unsigned CountTrailingZeros(uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctz(value);
+#else
+    unsigned n = 0;
+    while (!(value & 1u)) {
+        value >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Vector kernels that read whole aligned blocks may touch bytes past the end
+   of the string. Aligned blocks never cross a page, but ASan would object. */
+#if defined(__GNUC__) || defined(__clang__)
+#define SAFEOPS_NO_ASAN __attribute__((no_sanitize_address))
+#else
+#define SAFEOPS_NO_ASAN
+#endif
+
+/* wmemchr-style bounded length: index of the first L'\0' among the first
+   maxLen elements, or maxLen if there is none */
+SAFEOPS_NO_ASAN
+static size_t BoundedWStrLen(const wchar_t *str, size_t maxLen) {
+    if (maxLen == 0) {
+        return 0;
+    }
+
+#ifdef SAFEOPS_HAVE_SSE2
+    uintptr_t addr = (uintptr_t)str;
+    if ((addr % sizeof(wchar_t)) == 0) {
+        /* Aligned loads from the block containing str; lanes before str are masked off */
+        const char *base = (const char *)(addr & ~(uintptr_t)15);
+        size_t skip = (size_t)(addr & 15);
+        size_t limit = (maxLen > (SIZE_MAX - 16) / sizeof(wchar_t))
+                       ? SIZE_MAX : maxLen * sizeof(wchar_t) + skip;
+        const __m128i zero = _mm_setzero_si128();
+#if WCHAR_MAX > 0xFFFF
+#define WSTR_CMPEQ(v) _mm_cmpeq_epi32((v), zero)
+#else
+#define WSTR_CMPEQ(v) _mm_cmpeq_epi16((v), zero)
+#endif
+        size_t off = 0;
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(WSTR_CMPEQ(_mm_load_si128((const __m128i *)base)))
+                        & (0xFFFFu << skip);
+        while (!mask) {
+            off += 16;
+            if (off >= limit) {
+                return maxLen;
+            }
+            /* Four blocks per step on long strings, from a 64-byte boundary
+               so the wider read cannot cross into the next page */
+            while (((uintptr_t)(base + off) & 63) == 0 && limit - off > 64) {
+                __m128i e0 = WSTR_CMPEQ(_mm_load_si128((const __m128i *)(base + off)));
+                __m128i e1 = WSTR_CMPEQ(_mm_load_si128((const __m128i *)(base + off + 16)));
+                __m128i e2 = WSTR_CMPEQ(_mm_load_si128((const __m128i *)(base + off + 32)));
+                __m128i e3 = WSTR_CMPEQ(_mm_load_si128((const __m128i *)(base + off + 48)));
+                __m128i any = _mm_or_si128(_mm_or_si128(e0, e1), _mm_or_si128(e2, e3));
+                if (_mm_movemask_epi8(any)) {
+                    break;
+                }
+                off += 64;
+            }
+            mask = (uint32_t)_mm_movemask_epi8(WSTR_CMPEQ(_mm_load_si128((const __m128i *)(base + off))));
+        }
+#undef WSTR_CMPEQ
+        size_t index = (off + CountTrailingZeros(mask) - skip) / sizeof(wchar_t);
+        return index < maxLen ? index : maxLen;
+    }
+#endif
+
+    size_t len = 0;
+    while (len < maxLen && str[len] != L'\0') {
+        len++;
+    }
+    return len;
+}
+
+/* OR-accumulates a[i] ^ b[i] over the whole range. There is deliberately no
+   early exit, so the running time depends on len only, never on the data. */
+static unsigned char ConstTimeDiff(const unsigned char *a, const unsigned char *b, size_t len) {
+    size_t i = 0;
+    uint64_t wideAcc = 0;
+
+#ifdef SAFEOPS_HAVE_SSE2
+    __m128i vecAcc = _mm_setzero_si128();
+    for (; i + 16 <= len; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        vecAcc = _mm_or_si128(vecAcc, _mm_xor_si128(va, vb));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, vecAcc);
+    wideAcc = lanes[0] | lanes[1];
+#endif
+
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t wa, wb;
+        memcpy(&wa, a + i, sizeof(wa));
+        memcpy(&wb, b + i, sizeof(wb));
+        wideAcc |= wa ^ wb;
+    }
+
+    unsigned char acc = 0;
+    for (; i < len; i++) {
+        acc |= (unsigned char)(a[i] ^ b[i]);
+    }
+
+    wideAcc |= wideAcc >> 32;
+    wideAcc |= wideAcc >> 16;
+    wideAcc |= wideAcc >> 8;
+
+    /* volatile keeps the compiler from turning the reduction into a branch */
+    volatile unsigned char result = (unsigned char)(acc | (unsigned char)wideAcc);
+    return result;
+}
+
+bool SafeMemEqualCT(const void *a, const void *b, size_t len) {
+    if (!a || !b) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeMemEqualCT");
+        return false;
+    }
+
+    return ConstTimeDiff((const unsigned char *)a, (const unsigned char *)b, len) == 0;
+}
+
+bool SafeStrEqualCT(const char *a, const char *b, size_t maxLen) {
+    if (!a || !b) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeStrEqualCT");
+        return false;
+    }
+
+    /* The lengths are not secret; only the contents are compared in constant time */
+    size_t lenA = BoundedStrLen(a, maxLen);
+    size_t lenB = BoundedStrLen(b, maxLen);
+    size_t common = (lenA < lenB) ? lenA : lenB;
+
+    unsigned char diff = ConstTimeDiff((const unsigned char *)a, (const unsigned char *)b, common);
+    return (diff == 0) & (lenA == lenB);
+}
+
 /* ------------------------------------------------------
    2) Safe Copy / Move
    ------------------------------------------------------ */
@@ -186,10 +394,7 @@ bool SafeWStrLen(const wchar_t *str, size_t maxLen, size_t *outLen)
         return false;
     }
 
-    size_t len = 0;
-    while (len < maxLen && str[len] != L'\0') {
-        len++;
-    }
+    size_t len = BoundedWStrLen(str, maxLen);
 
     if (len == maxLen && str[len] != L'\0') {
         SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "String exceeds maximum length");
@@ -236,9 +441,40 @@ bool SafeStrCopy(char *dest, size_t destSize, const char *src)
     return true;
 }
 
-bool SafeWStrNCopy(wchar_t *dest, size_t destSize, const wchar_t *src, size_t count) {
+/* Appends at most count characters of src at dest + destLen. src is measured
+   only as far as the space left (one bounded scan) and then block-copied;
+   dest is untouched on failure. */
+static bool StrAppendBounded(char *dest, size_t destSize, size_t destLen,
+                             const char *src, size_t count) {
+    size_t room = destSize - destLen;  /* Including the terminator */
+    size_t srcLen = BoundedStrLen(src, count < room ? count : room);
+    if (srcLen >= room) {
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Insufficient destination buffer size");
+        return false;
+    }
+
+    memcpy(dest + destLen, src, srcLen);
+    dest[destLen + srcLen] = '\0';
+    return true;
+}
+
+static bool WStrAppendBounded(wchar_t *dest, size_t destSize, size_t destLen,
+                              const wchar_t *src, size_t count) {
+    size_t room = destSize - destLen;
+    size_t srcLen = BoundedWStrLen(src, count < room ? count : room);
+    if (srcLen >= room) {
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Insufficient destination buffer size");
+        return false;
+    }
+
+    memcpy(dest + destLen, src, srcLen * sizeof(wchar_t));
+    dest[destLen + srcLen] = L'\0';
+    return true;
+}
+
+bool SafeStrNCopy(char *dest, size_t destSize, const char *src, size_t count) {
     if (!dest || !src) {
-        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeWStrNCopy");
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeStrNCopy");
         return false;
     }
 
@@ -247,47 +483,59 @@ bool SafeWStrNCopy(wchar_t *dest, size_t destSize, const wchar_t *src, size_t co
         return false;
     }
 
-    size_t srcLen;
-    if (!SafeWStrLen(src, count, &srcLen)) {
+    return StrAppendBounded(dest, destSize, 0, src, count);
+}
+
+bool SafeStrNCat(char *dest, size_t destSize, const char *src, size_t count) {
+    if (!dest || !src) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeStrNCat");
         return false;
     }
 
-    /* Ensure space for null terminator */
-    size_t copyLen = (srcLen < count) ? srcLen : count;
-    if (copyLen >= destSize) {
-        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Insufficient destination buffer size");
+    size_t destLen = BoundedStrLen(dest, destSize);
+    if (destLen == destSize) {
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Destination is not terminated");
         return false;
     }
 
-    wcsncpy(dest, src, copyLen);
-    dest[copyLen] = L'\0';
-    return true;
+    return StrAppendBounded(dest, destSize, destLen, src, count);
 }
 
-bool SafeWStrNCat(wchar_t *dest, size_t destSize, const wchar_t *src, size_t count) {
+bool SafeWStrCopy(wchar_t *dest, size_t destSize, const wchar_t *src) {
+    return SafeWStrNCopy(dest, destSize, src, SIZE_MAX);
+}
+
+bool SafeWStrCat(wchar_t *dest, size_t destSize, const wchar_t *src) {
+    return SafeWStrNCat(dest, destSize, src, SIZE_MAX);
+}
+
+bool SafeWStrNCopy(wchar_t *dest, size_t destSize, const wchar_t *src, size_t count) {
     if (!dest || !src) {
-        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeWStrNCat");
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeWStrNCopy");
         return false;
     }
 
-    size_t destLen, srcLen;
-    if (!SafeWStrLen(dest, destSize, &destLen)) {
+    if (destSize == 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Destination size is 0");
         return false;
     }
 
-    if (!SafeWStrLen(src, count, &srcLen)) {
+    return WStrAppendBounded(dest, destSize, 0, src, count);
+}
+
+bool SafeWStrNCat(wchar_t *dest, size_t destSize, const wchar_t *src, size_t count) {
+    if (!dest || !src) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeWStrNCat");
         return false;
     }
 
-    size_t copyLen = (srcLen < count) ? srcLen : count;
-    if (destLen + copyLen >= destSize) {
-        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Concatenation would overflow buffer");
+    size_t destLen = BoundedWStrLen(dest, destSize);
+    if (destLen == destSize) {
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Destination is not terminated");
         return false;
     }
 
-    wcsncat(dest, src, copyLen);
-    dest[destLen + copyLen] = L'\0';
-    return true;
+    return WStrAppendBounded(dest, destSize, destLen, src, count);
 }
 
 bool SafeStrFind(const char *haystack, size_t haystackLen,
@@ -387,184 +635,7115 @@ bool SafeStrReplace(char *str, size_t strSize,
 }
 
 /* ------------------------------------------------------
-   3) Safe Indexed Read/Write
+   2b) Bounded Comparison
    ------------------------------------------------------ */
 
-bool SafeWriteInt(int *array, size_t arraySize, size_t index, int value)
-{
-    SAFE_RETURN_VAL_IF_FAIL(array, false);
-    SAFE_RETURN_VAL_IF_FAIL(index < arraySize, false);
-
-    array[index] = value;
-    return true;
+static unsigned char AsciiLower(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
 }
 
-bool SafeReadInt(const int *array, size_t arraySize, size_t index, int *outValue)
-{
-    SAFE_RETURN_VAL_IF_FAIL(array && outValue, false);
-    SAFE_RETURN_VAL_IF_FAIL(index < arraySize, false);
-
-    *outValue = array[index];
-    return true;
+#ifdef SAFEOPS_HAVE_SSE2
+/* Sets bit 0x20 on 'A'..'Z' lanes. Bytes >= 0x80 are negative as signed
+   chars, so they never fall in the range and are left untouched. */
+static __m128i AsciiLowerVec(__m128i v) {
+    __m128i geA = _mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1));
+    __m128i leZ = _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), v);
+    __m128i isUpper = _mm_and_si128(geA, leZ);
+    return _mm_or_si128(v, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
 }
+#endif
 
-/* ------------------------------------------------------
-   4) Safe Pointer Offsets
-   ------------------------------------------------------ */
+/* Index of the first differing byte, or len if the ranges are equal */
+static size_t MismatchIndex(const unsigned char *a, const unsigned char *b, size_t len) {
+    size_t i = 0;
 
-void* SafePointerOffset(void *base, size_t baseSize, size_t offset)
-{
-    SAFE_RETURN_VAL_IF_FAIL(base, NULL);
+#ifdef SAFEOPS_HAVE_SSE2
+    for (; i + 16 <= len; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        uint32_t eq = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+        if (eq != 0xFFFFu) {
+            return i + CountTrailingZeros(~eq & 0xFFFFu);
+        }
+    }
+#endif
 
-    /* Check for overflow in pointer arithmetic */
-    if (offset > baseSize ||
-        (uintptr_t)base + offset < (uintptr_t)base) {
-        errno = EOVERFLOW;
-        return NULL;
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t wa, wb;
+        memcpy(&wa, a + i, sizeof(wa));
+        memcpy(&wb, b + i, sizeof(wb));
+        if (wa != wb) {
+            break;
+        }
     }
 
-    return (char*)base + offset;
+    while (i < len && a[i] == b[i]) {
+        i++;
+    }
+    return i;
 }
 
-/* ------------------------------------------------------
-   5) Safe Arithmetic
-   ------------------------------------------------------ */
-
-bool SafeAddInt(int a, int b, int *result)
-{
-    SAFE_RETURN_VAL_IF_FAIL(result, false);
+/* Same as MismatchIndex, but ASCII letters compare case-insensitively */
+static size_t CaseMismatchIndex(const unsigned char *a, const unsigned char *b, size_t len) {
+    size_t i = 0;
 
-    /* Use GCC/Clang builtin if available */
-#if defined(__GNUC__) || defined(__clang__)
-    if (__builtin_sadd_overflow(a, b, result)) {
-            errno = EOVERFLOW;
-            return false;
+#ifdef SAFEOPS_HAVE_SSE2
+    for (; i + 16 <= len; i += 16) {
+        __m128i va = AsciiLowerVec(_mm_loadu_si128((const __m128i *)(a + i)));
+        __m128i vb = AsciiLowerVec(_mm_loadu_si128((const __m128i *)(b + i)));
+        uint32_t eq = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+        if (eq != 0xFFFFu) {
+            return i + CountTrailingZeros(~eq & 0xFFFFu);
         }
-#else
-    if ((b > 0 && a > INT_MAX - b) ||
-        (b < 0 && a < INT_MIN - b)) {
-        errno = EOVERFLOW;
-        return false;
     }
-    *result = a + b;
 #endif
 
-    return true;
+    while (i < len && AsciiLower(a[i]) == AsciiLower(b[i])) {
+        i++;
+    }
+    return i;
 }
 
-bool SafeCastLongLongToInt(long long val, int *out)
-{
-    SAFE_RETURN_VAL_IF_FAIL(out, false);
+static int CompareSign(int diff) {
+    return (diff > 0) - (diff < 0);
+}
 
-    if (val > INT_MAX || val < INT_MIN) {
-        errno = EOVERFLOW;
+/* Lexicographic result once the common prefix has been scanned: the first
+   differing byte decides, otherwise the shorter input orders first. */
+static int CompareResult(const unsigned char *a, size_t aLen,
+                         const unsigned char *b, size_t bLen,
+                         size_t mismatch, bool foldCase) {
+    size_t common = (aLen < bLen) ? aLen : bLen;
+    if (mismatch < common) {
+        if (foldCase) {
+            return CompareSign((int)AsciiLower(a[mismatch]) - (int)AsciiLower(b[mismatch]));
+        }
+        return CompareSign((int)a[mismatch] - (int)b[mismatch]);
+    }
+    return (aLen > bLen) - (aLen < bLen);
+}
+
+bool SafeMemCompare(const void *a, size_t aSize, const void *b, size_t bSize, int *outResult) {
+    if (!a || !b || !outResult) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeMemCompare");
         return false;
     }
 
-    *out = (int)val;
+    const unsigned char *pa = (const unsigned char *)a;
+    const unsigned char *pb = (const unsigned char *)b;
+    size_t common = (aSize < bSize) ? aSize : bSize;
+
+    *outResult = CompareResult(pa, aSize, pb, bSize, MismatchIndex(pa, pb, common), false);
     return true;
 }
 
-/* ------------------------------------------------------
-   6) Safe Printf
-   ------------------------------------------------------ */
-
-int SafePrintf(const char *format, ...)
-{
-    SAFE_RETURN_VAL_IF_FAIL(format, -1);
+bool SafeMemEqual(const void *a, size_t aSize, const void *b, size_t bSize) {
+    if (!a || !b) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeMemEqual");
+        return false;
+    }
 
-    va_list args;
-            va_start(args, format);
-    int ret = vprintf(format, args);
-            va_end(args);
+    /* Length-first: unequal sizes never touch the data */
+    if (aSize != bSize) {
+        return false;
+    }
 
-    return ret;
+    return MismatchIndex((const unsigned char *)a, (const unsigned char *)b, aSize) == aSize;
 }
 
-/* ------------------------------------------------------
-   7) TOCTOU & File Handling
-   ------------------------------------------------------ */
-
-FILE* SafeFOpen(const char *filePath, const char *mode, const SafeFileOpts *opts) {
-    if (!filePath || !mode) {
-        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFOpen");
-        return NULL;
+bool SafeStrCompare(const char *a, const char *b, size_t maxLen, int *outResult) {
+    if (!a || !b || !outResult) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeStrCompare");
+        return false;
     }
 
-    /* Use default options if none provided */
-    SafeFileOpts defaultOpts = {
-            .followSymlinks = false,
-            .requireRegularFile = true,
-            .createMode = 0644,
-            .secureDelete = false
-    };
-    if (!opts) opts = &defaultOpts;
+    size_t lenA = BoundedStrLen(a, maxLen);
+    size_t lenB = BoundedStrLen(b, maxLen);
+    size_t common = (lenA < lenB) ? lenA : lenB;
+    const unsigned char *pa = (const unsigned char *)a;
+    const unsigned char *pb = (const unsigned char *)b;
 
-    FILE *fp = NULL;
-    struct stat st;
+    *outResult = CompareResult(pa, lenA, pb, lenB, MismatchIndex(pa, pb, common), false);
+    return true;
+}
 
-#ifdef _WIN32
-    /* Windows implementation */
-    if (fopen_s(&fp, filePath, mode) != 0) {
-        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to open file");
-        return NULL;
+bool SafeStrCaseCompare(const char *a, const char *b, size_t maxLen, int *outResult) {
+    if (!a || !b || !outResult) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeStrCaseCompare");
+        return false;
     }
 
-    int fd = _fileno(fp);
-    if (_fstat(fd, &st) != 0) {
-        fclose(fp);
-        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to stat file");
-        return NULL;
+    size_t lenA = BoundedStrLen(a, maxLen);
+    size_t lenB = BoundedStrLen(b, maxLen);
+    size_t common = (lenA < lenB) ? lenA : lenB;
+    const unsigned char *pa = (const unsigned char *)a;
+    const unsigned char *pb = (const unsigned char *)b;
+
+    *outResult = CompareResult(pa, lenA, pb, lenB, CaseMismatchIndex(pa, pb, common), true);
+    return true;
+}
+
+bool SafeMemCaseCompare(const void *a, size_t aSize, const void *b, size_t bSize, int *outResult) {
+    if (!a || !b || !outResult) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeMemCaseCompare");
+        return false;
     }
-#else
-    /* POSIX implementation with enhanced security */
-    int flags = O_RDONLY;
-    if (strchr(mode, 'w')) flags = O_WRONLY | O_CREAT | O_TRUNC;
-    else if (strchr(mode, 'a')) flags = O_WRONLY | O_CREAT | O_APPEND;
 
-    if (!opts->followSymlinks) {
-        #ifdef O_NOFOLLOW
-            flags |= O_NOFOLLOW;
-        #endif
+    const unsigned char *pa = (const unsigned char *)a;
+    const unsigned char *pb = (const unsigned char *)b;
+    size_t common = (aSize < bSize) ? aSize : bSize;
+
+    *outResult = CompareResult(pa, aSize, pb, bSize, CaseMismatchIndex(pa, pb, common), true);
+    return true;
+}
+
+bool SafeMemCaseEqual(const void *a, size_t aSize, const void *b, size_t bSize) {
+    if (!a || !b) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeMemCaseEqual");
+        return false;
     }
 
-    int fd = open(filePath, flags, opts->createMode);
-    if (fd == -1) {
-        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to open file");
-        return NULL;
+    if (aSize != bSize) {
+        return false;
     }
 
-    /* Get file information using the file descriptor to avoid TOCTOU */
-    if (fstat(fd, &st) != 0) {
-        close(fd);
-        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to stat file");
-        return NULL;
+    return CaseMismatchIndex((const unsigned char *)a, (const unsigned char *)b, aSize) == aSize;
+}
+
+/* ------------------------------------------------------
+   2c) Unicode Transcoding
+   ------------------------------------------------------ */
+
+typedef enum {
+    TRANSCODE_OK,
+    TRANSCODE_INVALID,  /* Malformed input; count is its offset */
+    TRANSCODE_NO_ROOM   /* Output capacity exhausted */
+} TranscodeStatus;
+
+/* Decodes one multi-byte sequence (lead byte >= 0x80). Overlong forms,
+   surrogates and values above U+10FFFF are rejected. Returns the number of
+   bytes consumed, or 0 if the sequence is invalid or truncated. */
+static size_t Utf8DecodeMulti(const unsigned char *s, size_t avail, uint32_t *outCp) {
+    unsigned char c = s[0];
+    if (c >= 0xC2 && c <= 0xDF) {
+        if (avail < 2 || (s[1] & 0xC0) != 0x80) return 0;
+        *outCp = ((uint32_t)(c & 0x1F) << 6) | (uint32_t)(s[1] & 0x3F);
+        return 2;
     }
+    if (c >= 0xE0 && c <= 0xEF) {
+        if (avail < 3 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80) return 0;
+        uint32_t cp = ((uint32_t)(c & 0x0F) << 12) | ((uint32_t)(s[1] & 0x3F) << 6) |
+                      (uint32_t)(s[2] & 0x3F);
+        if (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF)) return 0;
+        *outCp = cp;
+        return 3;
+    }
+    if (c >= 0xF0 && c <= 0xF4) {
+        if (avail < 4 || (s[1] & 0xC0) != 0x80 || (s[2] & 0xC0) != 0x80 ||
+            (s[3] & 0xC0) != 0x80) return 0;
+        uint32_t cp = ((uint32_t)(c & 0x07) << 18) | ((uint32_t)(s[1] & 0x3F) << 12) |
+                      ((uint32_t)(s[2] & 0x3F) << 6) | (uint32_t)(s[3] & 0x3F);
+        if (cp < 0x10000 || cp > 0x10FFFF) return 0;
+        *outCp = cp;
+        return 4;
+    }
+    return 0;
+}
+
+/* UTF-8 to 16- or 32-bit code units. With out == NULL only counts units. */
+static TranscodeStatus Utf8ToUnits(const unsigned char *src, size_t len, void *out, size_t cap,
+                                   size_t unitSize, size_t *outCount) {
+    uint16_t *out16 = (uint16_t *)out;
+    uint32_t *out32 = (uint32_t *)out;
+    size_t i = 0, n = 0;
+
+    while (i < len) {
+#ifdef SAFEOPS_HAVE_SSE2
+        /* ASCII runs widen 16 bytes per step */
+        while (i + 16 <= len) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+            if (_mm_movemask_epi8(v) != 0 || (out && cap - n < 16)) {
+                break;
+            }
+            if (out) {
+                const __m128i zero = _mm_setzero_si128();
+                __m128i lo = _mm_unpacklo_epi8(v, zero);
+                __m128i hi = _mm_unpackhi_epi8(v, zero);
+                if (unitSize == 2) {
+                    _mm_storeu_si128((__m128i *)(out16 + n), lo);
+                    _mm_storeu_si128((__m128i *)(out16 + n + 8), hi);
+                } else {
+                    _mm_storeu_si128((__m128i *)(out32 + n), _mm_unpacklo_epi16(lo, zero));
+                    _mm_storeu_si128((__m128i *)(out32 + n + 4), _mm_unpackhi_epi16(lo, zero));
+                    _mm_storeu_si128((__m128i *)(out32 + n + 8), _mm_unpacklo_epi16(hi, zero));
+                    _mm_storeu_si128((__m128i *)(out32 + n + 12), _mm_unpackhi_epi16(hi, zero));
+                }
+            }
+            i += 16;
+            n += 16;
+        }
+        if (i >= len) {
+            break;
+        }
 #endif
+        uint32_t cp = src[i];
+        size_t used = 1;
+        if (cp >= 0x80) {
+            used = Utf8DecodeMulti(src + i, len - i, &cp);
+            if (used == 0) {
+                *outCount = i;
+                return TRANSCODE_INVALID;
+            }
+        }
+
+        size_t units = (unitSize == 2 && cp >= 0x10000) ? 2 : 1;
+        if (out) {
+            if (cap - n < units) {
+                *outCount = n;
+                return TRANSCODE_NO_ROOM;
+            }
+            if (unitSize == 4) {
+                out32[n] = cp;
+            } else if (units == 1) {
+                out16[n] = (uint16_t)cp;
+            } else {
+                cp -= 0x10000;
+                out16[n] = (uint16_t)(0xD800 | (cp >> 10));
+                out16[n + 1] = (uint16_t)(0xDC00 | (cp & 0x3FF));
+            }
+        }
+        n += units;
+        i += used;
+    }
+
+    *outCount = n;
+    return TRANSCODE_OK;
+}
+
+/* 16- or 32-bit code units to UTF-8. With out == NULL only counts bytes. */
+static TranscodeStatus UnitsToUtf8(const void *src, size_t len, size_t unitSize,
+                                   unsigned char *out, size_t cap, size_t *outCount) {
+    const uint16_t *in16 = (const uint16_t *)src;
+    const uint32_t *in32 = (const uint32_t *)src;
+    size_t i = 0, n = 0;
+
+    while (i < len) {
+#ifdef SAFEOPS_HAVE_SSE2
+        /* ASCII runs narrow 8 units per step */
+        const __m128i zero = _mm_setzero_si128();
+        while (i + 8 <= len && !(out && cap - n < 8)) {
+            __m128i packed;
+            if (unitSize == 2) {
+                __m128i v = _mm_loadu_si128((const __m128i *)(in16 + i));
+                __m128i high = _mm_and_si128(v, _mm_set1_epi16((short)0xFF80));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) != 0xFFFF) break;
+                packed = _mm_packus_epi16(v, v);
+            } else {
+                __m128i a = _mm_loadu_si128((const __m128i *)(in32 + i));
+                __m128i b = _mm_loadu_si128((const __m128i *)(in32 + i + 4));
+                __m128i high = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi32((int)0xFFFFFF80));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, zero)) != 0xFFFF) break;
+                packed = _mm_packs_epi32(a, b);
+                packed = _mm_packus_epi16(packed, packed);
+            }
+            if (out) {
+                _mm_storel_epi64((__m128i *)(out + n), packed);
+            }
+            i += 8;
+            n += 8;
+        }
+        if (i >= len) {
+            break;
+        }
+#endif
+        uint32_t cp;
+        size_t used = 1;
+        if (unitSize == 2) {
+            cp = in16[i];
+            if (cp >= 0xD800 && cp <= 0xDFFF) {
+                /* Needs a high surrogate followed by a low one */
+                if (cp > 0xDBFF || i + 1 >= len || in16[i + 1] < 0xDC00 || in16[i + 1] > 0xDFFF) {
+                    *outCount = i;
+                    return TRANSCODE_INVALID;
+                }
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (uint32_t)(in16[i + 1] - 0xDC00);
+                used = 2;
+            }
+        } else {
+            cp = in32[i];
+            if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+                *outCount = i;
+                return TRANSCODE_INVALID;
+            }
+        }
+
+        size_t bytes = (cp < 0x80) ? 1 : (cp < 0x800) ? 2 : (cp < 0x10000) ? 3 : 4;
+        if (out) {
+            if (cap - n < bytes) {
+                *outCount = n;
+                return TRANSCODE_NO_ROOM;
+            }
+            unsigned char *p = out + n;
+            switch (bytes) {
+                case 1:
+                    p[0] = (unsigned char)cp;
+                    break;
+                case 2:
+                    p[0] = (unsigned char)(0xC0 | (cp >> 6));
+                    p[1] = (unsigned char)(0x80 | (cp & 0x3F));
+                    break;
+                case 3:
+                    p[0] = (unsigned char)(0xE0 | (cp >> 12));
+                    p[1] = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+                    p[2] = (unsigned char)(0x80 | (cp & 0x3F));
+                    break;
+                default:
+                    p[0] = (unsigned char)(0xF0 | (cp >> 18));
+                    p[1] = (unsigned char)(0x80 | ((cp >> 12) & 0x3F));
+                    p[2] = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+                    p[3] = (unsigned char)(0x80 | (cp & 0x3F));
+                    break;
+            }
+        }
+        n += bytes;
+        i += used;
+    }
+
+    *outCount = n;
+    return TRANSCODE_OK;
+}
+
+/* Shared result handling: dest == NULL measures, otherwise one pass converts
+   and only a destination that turns out too small costs a second, counting pass */
+static bool FinishTranscode(TranscodeStatus status, size_t count, void *dest, size_t unitSize,
+                            size_t *outLen, const char *invalidMessage) {
+    if (status == TRANSCODE_OK) {
+        if (dest) {
+            if (unitSize == 1) ((char *)dest)[count] = '\0';
+            else if (unitSize == 2) ((uint16_t *)dest)[count] = 0;
+            else ((uint32_t *)dest)[count] = 0;
+        }
+        *outLen = count;
+        return true;
+    }
+
+    if (dest) {
+        if (unitSize == 1) ((char *)dest)[0] = '\0';
+        else if (unitSize == 2) ((uint16_t *)dest)[0] = 0;
+        else ((uint32_t *)dest)[0] = 0;
+    }
+    *outLen = count;
+    if (status == TRANSCODE_INVALID) {
+        SetError(SAFEOPS_ERR_INVALID_ENCODING, invalidMessage);
+    } else {
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Destination too small for converted string");
+    }
+    return false;
+}
+
+static bool TranscodeFromUtf8(const char *src, size_t srcLen, void *dest, size_t destSize,
+                              size_t unitSize, size_t *outLen) {
+    if (!src || !outLen) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in UTF-8 conversion");
+        return false;
+    }
+    if (dest && destSize == 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Destination size is 0");
+        return false;
+    }
+
+    size_t count;
+    const unsigned char *in = (const unsigned char *)src;
+    TranscodeStatus status = Utf8ToUnits(in, srcLen, dest, dest ? destSize - 1 : 0, unitSize, &count);
+    if (status == TRANSCODE_NO_ROOM) {
+        /* Report the size that would have been needed */
+        status = Utf8ToUnits(in, srcLen, NULL, 0, unitSize, &count);
+        if (status == TRANSCODE_OK) {
+            status = TRANSCODE_NO_ROOM;
+        }
+    }
+    return FinishTranscode(status, count, dest, unitSize, outLen, "Invalid UTF-8 sequence");
+}
+
+static bool TranscodeToUtf8(const void *src, size_t srcLen, size_t unitSize, char *dest,
+                            size_t destSize, size_t *outLen) {
+    if (!src || !outLen) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in UTF-8 conversion");
+        return false;
+    }
+    if (dest && destSize == 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Destination size is 0");
+        return false;
+    }
+
+    size_t count;
+    unsigned char *out = (unsigned char *)dest;
+    TranscodeStatus status = UnitsToUtf8(src, srcLen, unitSize, out, dest ? destSize - 1 : 0, &count);
+    if (status == TRANSCODE_NO_ROOM) {
+        status = UnitsToUtf8(src, srcLen, unitSize, NULL, 0, &count);
+        if (status == TRANSCODE_OK) {
+            status = TRANSCODE_NO_ROOM;
+        }
+    }
+    return FinishTranscode(status, count, dest, 1, outLen,
+                           unitSize == 2 ? "Invalid UTF-16 sequence" : "Invalid code point");
+}
+
+bool SafeUtf8ToUtf16(const char *src, size_t srcLen, uint16_t *dest, size_t destSize, size_t *outLen) {
+    return TranscodeFromUtf8(src, srcLen, dest, destSize, 2, outLen);
+}
+
+bool SafeUtf8ToUtf32(const char *src, size_t srcLen, uint32_t *dest, size_t destSize, size_t *outLen) {
+    return TranscodeFromUtf8(src, srcLen, dest, destSize, 4, outLen);
+}
+
+bool SafeUtf8ToWide(const char *src, size_t srcLen, wchar_t *dest, size_t destSize, size_t *outLen) {
+    return TranscodeFromUtf8(src, srcLen, dest, destSize, sizeof(wchar_t), outLen);
+}
+
+bool SafeUtf16ToUtf8(const uint16_t *src, size_t srcLen, char *dest, size_t destSize, size_t *outLen) {
+    return TranscodeToUtf8(src, srcLen, 2, dest, destSize, outLen);
+}
+
+bool SafeUtf32ToUtf8(const uint32_t *src, size_t srcLen, char *dest, size_t destSize, size_t *outLen) {
+    return TranscodeToUtf8(src, srcLen, 4, dest, destSize, outLen);
+}
+
+bool SafeWideToUtf8(const wchar_t *src, size_t srcLen, char *dest, size_t destSize, size_t *outLen) {
+    return TranscodeToUtf8(src, srcLen, sizeof(wchar_t), dest, destSize, outLen);
+}
+
+/* ------------------------------------------------------
+   2d) UTF-8 Validation
+   ------------------------------------------------------ */
+
+/* Checks s[start..len) one sequence at a time, skipping 8 ASCII bytes per step */
+static bool Utf8ValidateScalar(const unsigned char *s, size_t len, size_t start,
+                               size_t *outErr, size_t *outCount) {
+    size_t i = start, count = 0;
+    while (i < len) {
+        if (len - i >= 8) {
+            uint64_t word;
+            memcpy(&word, s + i, 8);
+            if ((word & 0x8080808080808080ULL) == 0) {
+                i += 8;
+                count += 8;
+                continue;
+            }
+        }
+        if (s[i] < 0x80) {
+            i++;
+        } else {
+            uint32_t cp;
+            size_t used = Utf8DecodeMulti(s + i, len - i, &cp);
+            if (used == 0) {
+                *outErr = i;
+                return false;
+            }
+            i += used;
+        }
+        count++;
+    }
+    *outCount = count;
+    return true;
+}
+
+#ifdef SAFEOPS_HAVE_X86_DISPATCH
+
+/* Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte".
+   Three nibble lookups classify each (previous byte, byte) pair; a bit that
+   survives the AND of all three marks an error. Sequences of 3 and 4 bytes
+   are then checked by looking two and three bytes back. */
+#define UTF8_TOO_SHORT   (1 << 0)
+#define UTF8_TOO_LONG    (1 << 1)
+#define UTF8_OVERLONG_3  (1 << 2)
+#define UTF8_TOO_LARGE   (1 << 3)
+#define UTF8_SURROGATE   (1 << 4)
+#define UTF8_OVERLONG_2  (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4  (1 << 6)
+#define UTF8_TWO_CONTS   (1 << 7)
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+#define UTF8_BYTE1_HIGH \
+    (char)UTF8_TOO_LONG, (char)UTF8_TOO_LONG, (char)UTF8_TOO_LONG, (char)UTF8_TOO_LONG, \
+    (char)UTF8_TOO_LONG, (char)UTF8_TOO_LONG, (char)UTF8_TOO_LONG, (char)UTF8_TOO_LONG, \
+    (char)UTF8_TWO_CONTS, (char)UTF8_TWO_CONTS, (char)UTF8_TWO_CONTS, (char)UTF8_TWO_CONTS, \
+    (char)(UTF8_TOO_SHORT | UTF8_OVERLONG_2), \
+    (char)UTF8_TOO_SHORT, \
+    (char)(UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE), \
+    (char)(UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4)
+
+#define UTF8_BYTE1_LOW \
+    (char)(UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4), \
+    (char)(UTF8_CARRY | UTF8_OVERLONG_2), \
+    (char)UTF8_CARRY, \
+    (char)UTF8_CARRY, \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE), \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000), \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000), \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000), \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000), \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000), \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000), \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000), \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000), \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE), \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000), \
+    (char)(UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000)
+
+#define UTF8_BYTE2_HIGH \
+    (char)UTF8_TOO_SHORT, (char)UTF8_TOO_SHORT, (char)UTF8_TOO_SHORT, (char)UTF8_TOO_SHORT, \
+    (char)UTF8_TOO_SHORT, (char)UTF8_TOO_SHORT, (char)UTF8_TOO_SHORT, (char)UTF8_TOO_SHORT, \
+    (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4), \
+    (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE), \
+    (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE), \
+    (char)(UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE), \
+    (char)UTF8_TOO_SHORT, (char)UTF8_TOO_SHORT, (char)UTF8_TOO_SHORT, (char)UTF8_TOO_SHORT
+
+/* A block flagged an error; the exact offset comes from a scalar rescan that
+   starts at the lead byte of the sequence straddling the block boundary */
+static bool Utf8LocateError(const unsigned char *s, size_t len, size_t blockStart, size_t *outErr) {
+    size_t p = blockStart;
+    for (size_t back = 1; back <= 3 && back <= blockStart; back++) {
+        unsigned char c = s[blockStart - back];
+        if ((c & 0xC0) != 0x80) {
+            if (c >= 0xC0) {
+                p = blockStart - back;
+            }
+            break;
+        }
+    }
+    size_t ignored;
+    if (Utf8ValidateScalar(s, len, p, outErr, &ignored)) {
+        *outErr = blockStart;  /* Not reached for a genuine error */
+    }
+    return false;
+}
+
+SAFEOPS_TARGET("avx2,popcnt")
+static bool Utf8ValidateAvx2(const unsigned char *s, size_t len, size_t *outErr, size_t *outCount) {
+    const __m256i byte1High = _mm256_setr_epi8(UTF8_BYTE1_HIGH, UTF8_BYTE1_HIGH);
+    const __m256i byte1Low = _mm256_setr_epi8(UTF8_BYTE1_LOW, UTF8_BYTE1_LOW);
+    const __m256i byte2High = _mm256_setr_epi8(UTF8_BYTE2_HIGH, UTF8_BYTE2_HIGH);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    /* Any byte above these in the last three positions starts an unfinished sequence */
+    const __m256i maxComplete = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    const __m256i notCont = _mm256_set1_epi8(-65);  /* Signed 0xBF */
+    __m256i prev = _mm256_setzero_si256();
+    __m256i prevIncomplete = _mm256_setzero_si256();
+    size_t count = 0;
+    unsigned char tail[32];
+
+    for (size_t i = 0; i < len; i += 32) {
+        __m256i in;
+        size_t avail = len - i;
+        if (avail >= 32) {
+            in = _mm256_loadu_si256((const __m256i *)(s + i));
+        } else {
+            /* Zero padding is ASCII, so it also exposes a truncated final sequence */
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, avail);
+            in = _mm256_loadu_si256((const __m256i *)tail);
+            count -= 32 - avail;
+        }
+
+        __m256i err;
+        if (_mm256_movemask_epi8(in) == 0) {
+            err = prevIncomplete;
+        } else {
+            __m256i carried = _mm256_permute2x128_si256(prev, in, 0x21);
+            __m256i prev1 = _mm256_alignr_epi8(in, carried, 15);
+            __m256i prev2 = _mm256_alignr_epi8(in, carried, 14);
+            __m256i prev3 = _mm256_alignr_epi8(in, carried, 13);
+            __m256i b1h = _mm256_shuffle_epi8(byte1High, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+            __m256i b1l = _mm256_shuffle_epi8(byte1Low, _mm256_and_si256(prev1, nibble));
+            __m256i b2h = _mm256_shuffle_epi8(byte2High, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+            __m256i special = _mm256_and_si256(_mm256_and_si256(b1h, b1l), b2h);
+            __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+            __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+            __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+            err = _mm256_xor_si256(must23, special);
+        }
+        if (!_mm256_testz_si256(err, err)) {
+            return Utf8LocateError(s, len, i, outErr);
+        }
+
+        prevIncomplete = _mm256_subs_epu8(in, maxComplete);
+        prev = in;
+        count += (size_t)__builtin_popcount((unsigned)_mm256_movemask_epi8(_mm256_cmpgt_epi8(in, notCont)));
+    }
+
+    if (!_mm256_testz_si256(prevIncomplete, prevIncomplete)) {
+        return Utf8LocateError(s, len, len, outErr);
+    }
+    *outCount = count;
+    return true;
+}
+
+SAFEOPS_TARGET("ssse3")
+static bool Utf8ValidateSsse3(const unsigned char *s, size_t len, size_t *outErr, size_t *outCount) {
+    const __m128i byte1High = _mm_setr_epi8(UTF8_BYTE1_HIGH);
+    const __m128i byte1Low = _mm_setr_epi8(UTF8_BYTE1_LOW);
+    const __m128i byte2High = _mm_setr_epi8(UTF8_BYTE2_HIGH);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i maxComplete = _mm_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    const __m128i notCont = _mm_set1_epi8(-65);
+    __m128i prev = _mm_setzero_si128();
+    __m128i prevIncomplete = _mm_setzero_si128();
+    size_t count = 0;
+    unsigned char tail[16];
+
+    for (size_t i = 0; i < len; i += 16) {
+        __m128i in;
+        size_t avail = len - i;
+        if (avail >= 16) {
+            in = _mm_loadu_si128((const __m128i *)(s + i));
+        } else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s + i, avail);
+            in = _mm_loadu_si128((const __m128i *)tail);
+            count -= 16 - avail;
+        }
+
+        __m128i err;
+        if (_mm_movemask_epi8(in) == 0) {
+            err = prevIncomplete;
+        } else {
+            __m128i prev1 = _mm_alignr_epi8(in, prev, 15);
+            __m128i prev2 = _mm_alignr_epi8(in, prev, 14);
+            __m128i prev3 = _mm_alignr_epi8(in, prev, 13);
+            __m128i b1h = _mm_shuffle_epi8(byte1High, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+            __m128i b1l = _mm_shuffle_epi8(byte1Low, _mm_and_si128(prev1, nibble));
+            __m128i b2h = _mm_shuffle_epi8(byte2High, _mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+            __m128i special = _mm_and_si128(_mm_and_si128(b1h, b1l), b2h);
+            __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+            __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+            __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+            err = _mm_xor_si128(must23, special);
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(err, _mm_setzero_si128())) != 0xFFFF) {
+            return Utf8LocateError(s, len, i, outErr);
+        }
+
+        prevIncomplete = _mm_subs_epu8(in, maxComplete);
+        prev = in;
+        count += (size_t)__builtin_popcount((unsigned)_mm_movemask_epi8(_mm_cmpgt_epi8(in, notCont)));
+    }
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(prevIncomplete, _mm_setzero_si128())) != 0xFFFF) {
+        return Utf8LocateError(s, len, len, outErr);
+    }
+    *outCount = count;
+    return true;
+}
+
+#endif /* SAFEOPS_HAVE_X86_DISPATCH */
+
+static bool Utf8Validate(const char *buf, size_t len, size_t *outErr, size_t *outCount) {
+    const unsigned char *s = (const unsigned char *)buf;
+#ifdef SAFEOPS_HAVE_X86_DISPATCH
+    if (len >= 64 && __builtin_cpu_supports("avx2")) {
+        return Utf8ValidateAvx2(s, len, outErr, outCount);
+    }
+    if (len >= 32 && __builtin_cpu_supports("ssse3")) {
+        return Utf8ValidateSsse3(s, len, outErr, outCount);
+    }
+#endif
+    return Utf8ValidateScalar(s, len, 0, outErr, outCount);
+}
+
+bool SafeUtf8Validate(const char *buf, size_t len, size_t *outErrorOffset) {
+    if (!buf && len > 0) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeUtf8Validate");
+        return false;
+    }
+
+    size_t errOffset = 0, count;
+    if (len > 0 && !Utf8Validate(buf, len, &errOffset, &count)) {
+        if (outErrorOffset) *outErrorOffset = errOffset;
+        SetError(SAFEOPS_ERR_INVALID_ENCODING, "Invalid UTF-8 sequence");
+        return false;
+    }
+    return true;
+}
+
+bool SafeUtf8CountCodePoints(const char *buf, size_t len, size_t *outCount, size_t *outErrorOffset) {
+    if ((!buf && len > 0) || !outCount) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeUtf8CountCodePoints");
+        return false;
+    }
+
+    size_t errOffset = 0, count = 0;
+    if (len > 0 && !Utf8Validate(buf, len, &errOffset, &count)) {
+        if (outErrorOffset) *outErrorOffset = errOffset;
+        SetError(SAFEOPS_ERR_INVALID_ENCODING, "Invalid UTF-8 sequence");
+        return false;
+    }
+    *outCount = count;
+    return true;
+}
+
+/* ------------------------------------------------------
+   2e) String Splitting
+   ------------------------------------------------------ */
+
+#define SPLIT_MODE_MASK 3u
+#define SPLIT_SMALL_SET 4  /* Sets up to this size use SSE2 compares */
+
+static bool ByteSetContains(const SafeStrSplitter *it, unsigned char c) {
+    return (it->setBitmap[c >> 3] >> (c & 7)) & 1;
+}
+
+#ifdef SAFEOPS_HAVE_X86_DISPATCH
+/* Nibble lookup: loTable[lo] has bit hi set when byte (hi << 4 | lo) is in the
+   set. One pshufb per table tests 16 bytes against any ASCII set. */
+SAFEOPS_TARGET("ssse3")
+static size_t FindByteSetSsse3(const unsigned char *s, size_t len, const unsigned char *loTable) {
+    const __m128i lo = _mm_loadu_si128((const __m128i *)loTable);
+    const __m128i hi = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i loBits = _mm_shuffle_epi8(lo, _mm_and_si128(v, nibble));
+        __m128i hiBits = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+        uint32_t miss = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(loBits, hiBits), zero));
+        if (miss != 0xFFFF) {
+            return i + CountTrailingZeros(~miss & 0xFFFFu);
+        }
+    }
+    return i;
+}
+#endif
+
+#ifdef SAFEOPS_HAVE_SSE2
+static size_t FindByteSetSse2(const unsigned char *s, size_t len, const unsigned char *set, size_t setLen) {
+    __m128i needles[SPLIT_SMALL_SET];
+    for (size_t k = 0; k < setLen; k++) {
+        needles[k] = _mm_set1_epi8((char)set[k]);
+    }
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i hit = _mm_cmpeq_epi8(v, needles[0]);
+        for (size_t k = 1; k < setLen; k++) {
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, needles[k]));
+        }
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(hit);
+        if (mask) {
+            return i + CountTrailingZeros(mask);
+        }
+    }
+    return i;
+}
+#endif
+
+/* Position of the next delimiter at or after from, or it->len if none */
+static size_t SplitFindDelim(const SafeStrSplitter *it, size_t from) {
+    const unsigned char *s = (const unsigned char *)it->buf + from;
+    size_t remaining = it->len - from;
+    if (remaining == 0) {
+        return it->len;
+    }
+
+    switch (it->flags & SPLIT_MODE_MASK) {
+        case SAFE_SPLIT_CHAR: {
+            const char *hit = (const char *)memchr(s, (unsigned char)it->delim[0], remaining);
+            return hit ? (size_t)(hit - it->buf) : it->len;
+        }
+        case SAFE_SPLIT_STRING: {
+            /* memchr on the first byte, then confirm the rest */
+            size_t pos = 0;
+            while (remaining - pos >= it->delimLen) {
+                const unsigned char *hit = (const unsigned char *)memchr(
+                    s + pos, (unsigned char)it->delim[0], remaining - pos - it->delimLen + 1);
+                if (!hit) {
+                    break;
+                }
+                pos = (size_t)(hit - s);
+                if (memcmp(hit + 1, it->delim + 1, it->delimLen - 1) == 0) {
+                    return from + pos;
+                }
+                pos++;
+            }
+            return it->len;
+        }
+        default: {
+            size_t i = 0;
+#ifdef SAFEOPS_HAVE_X86_DISPATCH
+            if (it->asciiSet && __builtin_cpu_supports("ssse3")) {
+                i = FindByteSetSsse3(s, remaining, it->setNibbles);
+            } else
+#endif
+#ifdef SAFEOPS_HAVE_SSE2
+            if (it->delimLen <= SPLIT_SMALL_SET) {
+                i = FindByteSetSse2(s, remaining, (const unsigned char *)it->delim, it->delimLen);
+            }
+#endif
+            for (; i < remaining; i++) {
+                if (ByteSetContains(it, s[i])) {
+                    break;
+                }
+            }
+            return from + i;
+        }
+    }
+}
+
+bool SafeStrSplitInit(SafeStrSplitter *it, const char *buf, size_t len,
+                      const char *delim, size_t delimLen, unsigned int flags) {
+    if (!it || (!buf && len > 0) || !delim) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeStrSplitInit");
+        return false;
+    }
+    unsigned int mode = flags & SPLIT_MODE_MASK;
+    if (delimLen == 0 || mode > SAFE_SPLIT_STRING || (mode == SAFE_SPLIT_CHAR && delimLen != 1)) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Invalid delimiter");
+        return false;
+    }
+
+    memset(it, 0, sizeof(*it));
+    it->buf = buf;
+    it->len = len;
+    it->delim = delim;
+    it->delimLen = delimLen;
+    it->flags = flags;
+
+    if (mode == SAFE_SPLIT_CHARSET) {
+        it->asciiSet = true;
+        for (size_t k = 0; k < delimLen; k++) {
+            unsigned char c = (unsigned char)delim[k];
+            it->setBitmap[c >> 3] |= (unsigned char)(1u << (c & 7));
+            if (c < 0x80) {
+                it->setNibbles[c & 0x0F] |= (unsigned char)(1u << (c >> 4));
+            } else {
+                it->asciiSet = false;
+            }
+        }
+    }
+    return true;
+}
+
+bool SafeStrSplitNext(SafeStrSplitter *it, SafeStrToken *outToken) {
+    if (!it || !outToken) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeStrSplitNext");
+        return false;
+    }
+
+    size_t step = ((it->flags & SPLIT_MODE_MASK) == SAFE_SPLIT_STRING) ? it->delimLen : 1;
+    while (!it->done) {
+        size_t start = it->pos;
+        size_t end = SplitFindDelim(it, start);
+        if (end >= it->len) {
+            it->done = true;  /* The text after the last delimiter is the final token */
+        } else {
+            it->pos = end + step;
+        }
+        if (end > start || !(it->flags & SAFE_SPLIT_SKIP_EMPTY)) {
+            outToken->offset = start;
+            outToken->len = end - start;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ------------------------------------------------------
+   2f) Hex, Base64 and Base32
+   ------------------------------------------------------ */
+
+static const char g_hexLower[] = "0123456789abcdef";
+static const char g_base64Std[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char g_base64Url[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+/* Value of a hex digit, -1 for anything else */
+static int HexValue(unsigned char c) {
+    if ((unsigned)(c - '0') <= 9) return c - '0';
+    c |= 0x20;
+    if ((unsigned)(c - 'a') <= 5) return c - 'a' + 10;
+    return -1;
+}
+
+/* Character to 6-bit value, -1 outside the alphabet */
+static const signed char g_base64StdValues[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+    -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+static const signed char g_base64UrlValues[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+    -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, 63,
+    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+/* Room check shared by the encoders: a short dest is left empty */
+static bool EncodeFits(char *dest, size_t destSize, size_t needed) {
+    if (destSize == 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Destination size is 0");
+        return false;
+    }
+    if (needed >= destSize) {
+        dest[0] = '\0';
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Destination too small for encoded data");
+        return false;
+    }
+    return true;
+}
+
+#ifdef SAFEOPS_HAVE_X86_DISPATCH
+/* Mask of bytes within [lo, lo + count) using the signed-compare bias trick */
+SAFEOPS_TARGET("avx2")
+static __m256i ByteRangeAvx2(__m256i c, char lo, int count) {
+    __m256i shifted = _mm256_add_epi8(c, _mm256_set1_epi8((char)(0x80 - lo)));
+    return _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + count)), shifted);
+}
+
+/* 32 input bytes to 64 hex characters per iteration; returns bytes consumed */
+SAFEOPS_TARGET("avx2")
+static size_t HexEncodeAvx2(char *dest, const unsigned char *src, size_t srcLen) {
+    const __m256i digits = _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
+                                            'a', 'b', 'c', 'd', 'e', 'f',
+                                            '0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
+                                            'a', 'b', 'c', 'd', 'e', 'f');
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; srcLen - i >= 32; i += 32) {
+        __m256i in = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i high = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+        __m256i low = _mm256_shuffle_epi8(digits, _mm256_and_si256(in, nibble));
+        /* Interleave works per 128-bit lane; the permutes restore byte order */
+        __m256i first = _mm256_unpacklo_epi8(high, low);
+        __m256i second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256((__m256i *)(dest + 2 * i), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i *)(dest + 2 * i + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    return i;
+}
+
+/* 64 hex characters to 32 bytes per iteration; stops before any block
+   holding a non-hex character so the scalar loop can report it */
+SAFEOPS_TARGET("avx2")
+static size_t HexDecodeAvx2(unsigned char *dest, const char *src, size_t srcLen) {
+    const __m256i weights = _mm256_set1_epi16(0x0110);  /* High digit * 16 + low digit */
+    size_t i = 0;
+    for (; srcLen - i >= 64; i += 64) {
+        __m256i values[2];
+        bool valid = true;
+        for (int k = 0; k < 2; k++) {
+            __m256i c = _mm256_loadu_si256((const __m256i *)(src + i + 32 * k));
+            __m256i digit = ByteRangeAvx2(c, '0', 10);
+            __m256i lower = ByteRangeAvx2(c, 'a', 6);
+            __m256i upper = ByteRangeAvx2(c, 'A', 6);
+            __m256i offset = _mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(-'0')),
+                             _mm256_or_si256(_mm256_and_si256(lower, _mm256_set1_epi8(10 - 'a')),
+                                             _mm256_and_si256(upper, _mm256_set1_epi8(10 - 'A'))));
+            valid &= (_mm256_movemask_epi8(_mm256_or_si256(digit, _mm256_or_si256(lower, upper))) == -1);
+            values[k] = _mm256_maddubs_epi16(_mm256_add_epi8(c, offset), weights);
+        }
+        if (!valid) {
+            break;
+        }
+        __m256i packed = _mm256_packus_epi16(values[0], values[1]);
+        _mm256_storeu_si256((__m256i *)(dest + i / 2), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return i;
+}
+
+/* 24 input bytes to 32 characters per iteration (Mula & Lemire). Each lane
+   loads 16 bytes and uses 12, so 28 bytes must be readable. */
+SAFEOPS_TARGET("avx2")
+static size_t Base64EncodeAvx2(char *dest, const unsigned char *src, size_t srcLen, unsigned int flags) {
+    const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    /* Offset from a 6-bit value to its character, indexed by value range */
+    const char plus = (flags & SAFE_BASE64_URL) ? (char)('-' - 62) : (char)('+' - 62);
+    const char slash = (flags & SAFE_BASE64_URL) ? (char)('_' - 63) : (char)('/' - 63);
+    const __m256i offsets = _mm256_setr_epi8('A', 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             plus, slash, 0, 0,
+                                             'A', 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             plus, slash, 0, 0);
+    size_t i = 0, o = 0;
+    for (; srcLen - i >= 28; i += 24, o += 32) {
+        __m256i in = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(src + i))),
+                _mm_loadu_si128((const __m128i *)(src + i + 12)), 1);
+        in = _mm256_shuffle_epi8(in, spread);
+        /* Move the four 6-bit fields of each 32-bit group into separate bytes */
+        __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)),
+                                        _mm256_set1_epi32(0x04000040));
+        __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)),
+                                        _mm256_set1_epi32(0x01000010));
+        __m256i values = _mm256_or_si256(t0, t1);
+
+        __m256i index = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+        index = _mm256_sub_epi8(index, _mm256_cmpgt_epi8(values, _mm256_set1_epi8(25)));
+        __m256i chars = _mm256_add_epi8(values, _mm256_shuffle_epi8(offsets, index));
+        _mm256_storeu_si256((__m256i *)(dest + o), chars);
+    }
+    return i;
+}
+
+/* 32 characters to 24 bytes per iteration; each store writes 32 bytes, so the
+   caller guarantees 8 bytes of slack. Stops before a block with padding or
+   an invalid character. */
+SAFEOPS_TARGET("avx2")
+static size_t Base64DecodeAvx2(unsigned char *dest, size_t destRoom, const char *src, size_t srcLen,
+                               unsigned int flags) {
+    const char c62 = (flags & SAFE_BASE64_URL) ? '-' : '+';
+    const char c63 = (flags & SAFE_BASE64_URL) ? '_' : '/';
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    size_t i = 0, o = 0;
+    for (; srcLen - i >= 32 && destRoom - o >= 32; i += 32, o += 24) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i upper = ByteRangeAvx2(c, 'A', 26);
+        __m256i lower = ByteRangeAvx2(c, 'a', 26);
+        __m256i digit = ByteRangeAvx2(c, '0', 10);
+        __m256i is62 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(c62));
+        __m256i is63 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(c63));
+        __m256i known = _mm256_or_si256(_mm256_or_si256(upper, lower),
+                                        _mm256_or_si256(digit, _mm256_or_si256(is62, is63)));
+        if (_mm256_movemask_epi8(known) != -1) {
+            break;
+        }
+        __m256i offset = _mm256_or_si256(
+                _mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')),
+                                _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+                _mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+                                _mm256_or_si256(_mm256_and_si256(is62, _mm256_set1_epi8((char)(62 - c62))),
+                                                _mm256_and_si256(is63, _mm256_set1_epi8((char)(63 - c63))))));
+        __m256i values = _mm256_add_epi8(c, offset);
+        /* Join 4 x 6 bits into 3 bytes per 32-bit group, then compact the lanes */
+        __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        __m256i groups = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        groups = _mm256_shuffle_epi8(groups, pack);
+        _mm256_storeu_si256((__m256i *)(dest + o), _mm256_permutevar8x32_epi32(groups, lanes));
+    }
+    return i;
+}
+#endif
+
+size_t SafeHexEncodedLen(size_t srcLen) {
+    if (srcLen > (SIZE_MAX - 1) / 2) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Encoded size would overflow");
+        return SIZE_MAX;
+    }
+    return srcLen * 2;
+}
+
+bool SafeHexEncode(char *dest, size_t destSize, const void *src, size_t srcLen, size_t *outLen) {
+    if (!src || !outLen) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeHexEncode");
+        return false;
+    }
+    size_t needed = SafeHexEncodedLen(srcLen);
+    if (needed == SIZE_MAX) {
+        return false;
+    }
+    *outLen = needed;
+    if (!dest) {
+        return true;
+    }
+    if (!EncodeFits(dest, destSize, needed)) {
+        return false;
+    }
+
+    const unsigned char *in = (const unsigned char *)src;
+    size_t i = 0;
+#ifdef SAFEOPS_HAVE_X86_DISPATCH
+    if (srcLen >= 32 && __builtin_cpu_supports("avx2")) {
+        i = HexEncodeAvx2(dest, in, srcLen);
+    }
+#endif
+    for (; i < srcLen; i++) {
+        dest[2 * i] = g_hexLower[in[i] >> 4];
+        dest[2 * i + 1] = g_hexLower[in[i] & 0xF];
+    }
+    dest[needed] = '\0';
+    return true;
+}
+
+bool SafeHexDecode(void *dest, size_t destSize, const char *src, size_t srcLen, size_t *outLen) {
+    if (!src || !outLen) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeHexDecode");
+        return false;
+    }
+    if (srcLen % 2 != 0) {
+        *outLen = srcLen;
+        SetError(SAFEOPS_ERR_INVALID_ENCODING, "Hex input has an odd length");
+        return false;
+    }
+    size_t needed = srcLen / 2;
+    if (dest && needed > destSize) {
+        *outLen = needed;
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Destination too small for decoded data");
+        return false;
+    }
+
+    unsigned char *out = (unsigned char *)dest;
+    size_t i = 0;
+#ifdef SAFEOPS_HAVE_X86_DISPATCH
+    if (out && srcLen >= 64 && __builtin_cpu_supports("avx2")) {
+        i = HexDecodeAvx2(out, src, srcLen);
+    }
+#endif
+    for (; i < srcLen; i += 2) {
+        int high = HexValue((unsigned char)src[i]);
+        int low = HexValue((unsigned char)src[i + 1]);
+        if (high < 0 || low < 0) {
+            *outLen = (high < 0) ? i : i + 1;
+            SetError(SAFEOPS_ERR_INVALID_ENCODING, "Invalid hex digit");
+            return false;
+        }
+        if (out) {
+            out[i / 2] = (unsigned char)(high << 4 | low);
+        }
+    }
+    *outLen = needed;
+    return true;
+}
+
+size_t SafeBase64EncodedLen(size_t srcLen, unsigned int flags) {
+    size_t groups = srcLen / 3;
+    size_t tail = srcLen % 3;
+    if (groups > (SIZE_MAX - 4) / 4) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Encoded size would overflow");
+        return SIZE_MAX;
+    }
+    if (tail == 0) {
+        return groups * 4;
+    }
+    return groups * 4 + ((flags & SAFE_BASE64_NO_PAD) ? tail + 1 : 4);
+}
+
+size_t SafeBase64DecodedLen(const char *src, size_t srcLen, unsigned int flags) {
+    if (!src) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeBase64DecodedLen");
+        return 0;
+    }
+    if (!(flags & SAFE_BASE64_NO_PAD)) {
+        for (int k = 0; k < 2 && srcLen > 0 && src[srcLen - 1] == '='; k++) {
+            srcLen--;
+        }
+    }
+    size_t tail = srcLen % 4;
+    return srcLen / 4 * 3 + (tail ? tail - 1 : 0);
+}
+
+bool SafeBase64Encode(char *dest, size_t destSize, const void *src, size_t srcLen,
+                      unsigned int flags, size_t *outLen) {
+    if (!src || !outLen) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeBase64Encode");
+        return false;
+    }
+    size_t needed = SafeBase64EncodedLen(srcLen, flags);
+    if (needed == SIZE_MAX) {
+        return false;
+    }
+    *outLen = needed;
+    if (!dest) {
+        return true;
+    }
+    if (!EncodeFits(dest, destSize, needed)) {
+        return false;
+    }
+
+    const char *alphabet = (flags & SAFE_BASE64_URL) ? g_base64Url : g_base64Std;
+    const unsigned char *in = (const unsigned char *)src;
+    size_t i = 0;
+#ifdef SAFEOPS_HAVE_X86_DISPATCH
+    if (srcLen >= 28 && __builtin_cpu_supports("avx2")) {
+        i = Base64EncodeAvx2(dest, in, srcLen, flags);
+    }
+#endif
+    char *out = dest + i / 3 * 4;
+    for (; srcLen - i >= 3; i += 3) {
+        uint32_t group = (uint32_t)in[i] << 16 | (uint32_t)in[i + 1] << 8 | in[i + 2];
+        *out++ = alphabet[group >> 18];
+        *out++ = alphabet[(group >> 12) & 0x3F];
+        *out++ = alphabet[(group >> 6) & 0x3F];
+        *out++ = alphabet[group & 0x3F];
+    }
+    if (i < srcLen) {
+        uint32_t group = (uint32_t)in[i] << 16 | (srcLen - i == 2 ? (uint32_t)in[i + 1] << 8 : 0);
+        *out++ = alphabet[group >> 18];
+        *out++ = alphabet[(group >> 12) & 0x3F];
+        if (srcLen - i == 2) {
+            *out++ = alphabet[(group >> 6) & 0x3F];
+        } else if (!(flags & SAFE_BASE64_NO_PAD)) {
+            *out++ = '=';
+        }
+        if (!(flags & SAFE_BASE64_NO_PAD)) {
+            *out++ = '=';
+        }
+    }
+    *out = '\0';
+    return true;
+}
+
+bool SafeBase64Decode(void *dest, size_t destSize, const char *src, size_t srcLen,
+                      unsigned int flags, size_t *outLen) {
+    if (!src || !outLen) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeBase64Decode");
+        return false;
+    }
+
+    /* Shape first: padding only at the end, and a length some input encodes to */
+    size_t dataLen = srcLen;
+    if (!(flags & SAFE_BASE64_NO_PAD)) {
+        if (srcLen % 4 != 0) {
+            *outLen = srcLen;
+            SetError(SAFEOPS_ERR_INVALID_ENCODING, "Base64 input is not padded to a multiple of 4");
+            return false;
+        }
+        for (int k = 0; k < 2 && dataLen > 0 && src[dataLen - 1] == '='; k++) {
+            dataLen--;
+        }
+    }
+    if (dataLen % 4 == 1) {
+        *outLen = dataLen;
+        SetError(SAFEOPS_ERR_INVALID_ENCODING, "Truncated base64 input");
+        return false;
+    }
+    size_t needed = SafeBase64DecodedLen(src, srcLen, flags);
+    if (dest && needed > destSize) {
+        *outLen = needed;
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Destination too small for decoded data");
+        return false;
+    }
+
+    const signed char *values = (flags & SAFE_BASE64_URL) ? g_base64UrlValues : g_base64StdValues;
+    unsigned char *out = (unsigned char *)dest;
+    size_t i = 0, o = 0;
+#ifdef SAFEOPS_HAVE_X86_DISPATCH
+    if (out && dataLen >= 32 && __builtin_cpu_supports("avx2")) {
+        i = Base64DecodeAvx2(out, destSize, src, dataLen, flags);
+        o = i / 4 * 3;
+    }
+#endif
+    for (; i < dataLen; i += 4) {
+        size_t count = (dataLen - i < 4) ? dataLen - i : 4;
+        uint32_t group = 0;
+        for (size_t k = 0; k < count; k++) {
+            int value = values[(unsigned char)src[i + k]];
+            if (value < 0) {
+                *outLen = i + k;
+                SetError(SAFEOPS_ERR_INVALID_ENCODING, "Invalid base64 character");
+                return false;
+            }
+            group |= (uint32_t)value << (18 - 6 * k);
+        }
+        /* The bits below the last whole byte must be zero, or two inputs
+           would decode to the same bytes */
+        if ((count == 2 && (group & 0xFFFF)) || (count == 3 && (group & 0xFF))) {
+            *outLen = i + count - 1;
+            SetError(SAFEOPS_ERR_INVALID_ENCODING, "Non-canonical base64 padding bits");
+            return false;
+        }
+        if (out) {
+            out[o] = (unsigned char)(group >> 16);
+            if (count > 2) out[o + 1] = (unsigned char)(group >> 8);
+            if (count > 3) out[o + 2] = (unsigned char)group;
+        }
+        o += count - 1;
+    }
+    *outLen = needed;
+    return true;
+}
+
+static const char g_base32[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+static int Base32Value(unsigned char c) {
+    if ((unsigned)(c - 'A') <= 25) return c - 'A';
+    if ((unsigned)(c - '2') <= 5) return c - '2' + 26;
+    return -1;
+}
+
+size_t SafeBase32EncodedLen(size_t srcLen, unsigned int flags) {
+    size_t groups = srcLen / 5;
+    size_t tail = srcLen % 5;
+    if (groups > (SIZE_MAX - 8) / 8) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Encoded size would overflow");
+        return SIZE_MAX;
+    }
+    if (tail == 0) {
+        return groups * 8;
+    }
+    return groups * 8 + ((flags & SAFE_BASE32_NO_PAD) ? (tail * 8 + 4) / 5 : 8);
+}
+
+size_t SafeBase32DecodedLen(const char *src, size_t srcLen, unsigned int flags) {
+    if (!src) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeBase32DecodedLen");
+        return 0;
+    }
+    if (!(flags & SAFE_BASE32_NO_PAD)) {
+        for (int k = 0; k < 6 && srcLen > 0 && src[srcLen - 1] == '='; k++) {
+            srcLen--;
+        }
+    }
+    return srcLen / 8 * 5 + srcLen % 8 * 5 / 8;
+}
+
+bool SafeBase32Encode(char *dest, size_t destSize, const void *src, size_t srcLen,
+                      unsigned int flags, size_t *outLen) {
+    if (!src || !outLen) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeBase32Encode");
+        return false;
+    }
+    size_t needed = SafeBase32EncodedLen(srcLen, flags);
+    if (needed == SIZE_MAX) {
+        return false;
+    }
+    *outLen = needed;
+    if (!dest) {
+        return true;
+    }
+    if (!EncodeFits(dest, destSize, needed)) {
+        return false;
+    }
+
+    const unsigned char *in = (const unsigned char *)src;
+    char *out = dest;
+    for (size_t i = 0; i < srcLen; i += 5) {
+        size_t count = (srcLen - i < 5) ? srcLen - i : 5;
+        uint64_t group = 0;
+        for (size_t k = 0; k < 5; k++) {
+            group = group << 8 | (k < count ? in[i + k] : 0);
+        }
+        size_t chars = (count * 8 + 4) / 5;
+        for (size_t k = 0; k < chars; k++) {
+            *out++ = g_base32[(group >> (35 - 5 * k)) & 0x1F];
+        }
+        if (count < 5 && !(flags & SAFE_BASE32_NO_PAD)) {
+            for (size_t k = chars; k < 8; k++) {
+                *out++ = '=';
+            }
+        }
+    }
+    *out = '\0';
+    return true;
+}
+
+bool SafeBase32Decode(void *dest, size_t destSize, const char *src, size_t srcLen,
+                      unsigned int flags, size_t *outLen) {
+    if (!src || !outLen) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeBase32Decode");
+        return false;
+    }
+
+    size_t dataLen = srcLen;
+    if (!(flags & SAFE_BASE32_NO_PAD)) {
+        if (srcLen % 8 != 0) {
+            *outLen = srcLen;
+            SetError(SAFEOPS_ERR_INVALID_ENCODING, "Base32 input is not padded to a multiple of 8");
+            return false;
+        }
+        for (int k = 0; k < 6 && dataLen > 0 && src[dataLen - 1] == '='; k++) {
+            dataLen--;
+        }
+    }
+    size_t tail = dataLen % 8;
+    if (tail == 1 || tail == 3 || tail == 6) {
+        *outLen = srcLen;
+        SetError(SAFEOPS_ERR_INVALID_ENCODING, "Truncated base32 input");
+        return false;
+    }
+    size_t needed = SafeBase32DecodedLen(src, srcLen, flags);
+    if (dest && needed > destSize) {
+        *outLen = needed;
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Destination too small for decoded data");
+        return false;
+    }
+
+    unsigned char *out = (unsigned char *)dest;
+    size_t o = 0;
+    for (size_t i = 0; i < dataLen; i += 8) {
+        size_t count = (dataLen - i < 8) ? dataLen - i : 8;
+        uint64_t group = 0;
+        for (size_t k = 0; k < count; k++) {
+            int value = Base32Value((unsigned char)src[i + k]);
+            if (value < 0) {
+                *outLen = i + k;
+                SetError(SAFEOPS_ERR_INVALID_ENCODING, "Invalid base32 character");
+                return false;
+            }
+            group |= (uint64_t)value << (35 - 5 * k);
+        }
+        size_t bytes = count * 5 / 8;
+        if (group & ((1ULL << (40 - 8 * bytes)) - 1)) {
+            *outLen = i + count - 1;
+            SetError(SAFEOPS_ERR_INVALID_ENCODING, "Non-canonical base32 padding bits");
+            return false;
+        }
+        for (size_t k = 0; out && k < bytes; k++) {
+            out[o + k] = (unsigned char)(group >> (32 - 8 * k));
+        }
+        o += bytes;
+    }
+    *outLen = needed;
+    return true;
+}
+
+/* ------------------------------------------------------
+   2g) Escaping
+   ------------------------------------------------------ */
+
+typedef enum {
+    ESCAPE_JSON,
+    ESCAPE_HTML,
+    ESCAPE_URL
+} EscapeKind;
+
+#define ESCAPE_MAX_SEQ 6  /* Longest replacement: \u00XX, &quot; */
+
+static bool EscapeNeeded(EscapeKind kind, unsigned char c) {
+    switch (kind) {
+        case ESCAPE_JSON:
+            return c < 0x20 || c == '"' || c == '\\';
+        case ESCAPE_HTML:
+            return c == '&' || c == '<' || c == '>' || c == '"' || c == '\'';
+        default:
+            /* RFC 3986 unreserved characters pass through */
+            return !((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+                     c == '-' || c == '.' || c == '_' || c == '~');
+    }
+}
+
+/* Writes the replacement for c into seq and returns its length */
+static size_t EscapeSequence(EscapeKind kind, unsigned char c, char *seq) {
+    static const char upperHex[] = "0123456789ABCDEF";
+    const char *text = NULL;
+    switch (kind) {
+        case ESCAPE_JSON:
+            switch (c) {
+                case '"': text = "\\\""; break;
+                case '\\': text = "\\\\"; break;
+                case '\b': text = "\\b"; break;
+                case '\f': text = "\\f"; break;
+                case '\n': text = "\\n"; break;
+                case '\r': text = "\\r"; break;
+                case '\t': text = "\\t"; break;
+                default:
+                    memcpy(seq, "\\u00", 4);
+                    seq[4] = g_hexLower[c >> 4];
+                    seq[5] = g_hexLower[c & 0xF];
+                    return 6;
+            }
+            break;
+        case ESCAPE_HTML:
+            switch (c) {
+                case '&': text = "&amp;"; break;
+                case '<': text = "&lt;"; break;
+                case '>': text = "&gt;"; break;
+                case '"': text = "&quot;"; break;
+                default: text = "&#39;"; break;
+            }
+            break;
+        default:
+            seq[0] = '%';
+            seq[1] = upperHex[c >> 4];
+            seq[2] = upperHex[c & 0xF];
+            return 3;
+    }
+    size_t len = strlen(text);
+    memcpy(seq, text, len);
+    return len;
+}
+
+#ifdef SAFEOPS_HAVE_SSE2
+/* Movemask of the bytes in v that need escaping */
+static uint32_t EscapeMaskSse2(EscapeKind kind, __m128i v) {
+    switch (kind) {
+        case ESCAPE_JSON: {
+            /* Saturating subtract leaves zero exactly for bytes <= 0x1F */
+            __m128i control = _mm_cmpeq_epi8(_mm_subs_epu8(v, _mm_set1_epi8(0x1F)), _mm_setzero_si128());
+            __m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+            __m128i slash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+            return (uint32_t)_mm_movemask_epi8(_mm_or_si128(control, _mm_or_si128(quote, slash)));
+        }
+        case ESCAPE_HTML: {
+            __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('&')),
+                                       _mm_cmpeq_epi8(v, _mm_set1_epi8('<')));
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8('>')));
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8('\'')));
+            return (uint32_t)_mm_movemask_epi8(hit);
+        }
+        default: {
+            /* Fold case so one range test covers both alphabets */
+            __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+            __m128i alpha = _mm_cmplt_epi8(_mm_add_epi8(folded, _mm_set1_epi8((char)(0x80 - 'a'))),
+                                           _mm_set1_epi8(-128 + 26));
+            __m128i digit = _mm_cmplt_epi8(_mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - '0'))),
+                                           _mm_set1_epi8(-128 + 10));
+            __m128i mark = _mm_cmplt_epi8(_mm_add_epi8(v, _mm_set1_epi8((char)(0x80 - '-'))),
+                                          _mm_set1_epi8(-128 + 2));  /* '-' and '.' */
+            mark = _mm_or_si128(mark, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+            mark = _mm_or_si128(mark, _mm_cmpeq_epi8(v, _mm_set1_epi8('~')));
+            __m128i keep = _mm_or_si128(_mm_or_si128(alpha, digit), mark);
+            return (uint32_t)_mm_movemask_epi8(keep) ^ 0xFFFFu;
+        }
+    }
+}
+#endif
+
+/* Length of the leading run of s that can be copied unchanged */
+static size_t EscapeCleanRun(EscapeKind kind, const unsigned char *s, size_t len) {
+    size_t i = 0;
+#ifdef SAFEOPS_HAVE_SSE2
+    for (; i + 16 <= len; i += 16) {
+        uint32_t mask = EscapeMaskSse2(kind, _mm_loadu_si128((const __m128i *)(s + i)));
+        if (mask) {
+            return i + CountTrailingZeros(mask);
+        }
+    }
+#endif
+    while (i < len && !EscapeNeeded(kind, s[i])) {
+        i++;
+    }
+    return i;
+}
+
+/* Escapes src into dest for as long as the output fits in room bytes and
+   returns the full escaped length. dest may be NULL when room is 0. */
+static size_t EscapeInto(EscapeKind kind, char *dest, size_t room, const unsigned char *src, size_t srcLen) {
+    size_t out = 0;
+    size_t i = 0;
+    while (i < srcLen) {
+        size_t run = EscapeCleanRun(kind, src + i, srcLen - i);
+        if (run > 0 && out <= room && run <= room - out) {
+            memcpy(dest + out, src + i, run);
+        }
+        out += run;
+        i += run;
+        if (i == srcLen) {
+            break;
+        }
+        char seq[ESCAPE_MAX_SEQ];
+        size_t seqLen = EscapeSequence(kind, src[i], seq);
+        if (out <= room && seqLen <= room - out) {
+            memcpy(dest + out, seq, seqLen);
+        }
+        out += seqLen;
+        i++;
+    }
+    return out;
+}
+
+static bool EscapeString(EscapeKind kind, const char *caller, char *dest, size_t destSize,
+                         const char *src, size_t srcLen, size_t *outLen) {
+    if (!src || !outLen) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, caller);
+        return false;
+    }
+    if (srcLen > SIZE_MAX / ESCAPE_MAX_SEQ) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Escaped size would overflow");
+        return false;
+    }
+    const unsigned char *in = (const unsigned char *)src;
+    if (!dest) {
+        *outLen = EscapeInto(kind, NULL, 0, in, srcLen);
+        return true;
+    }
+    if (destSize == 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Destination size is 0");
+        return false;
+    }
+
+    /* Escape straight into dest; the size pass only matters when it is short */
+    size_t needed = EscapeInto(kind, dest, destSize - 1, in, srcLen);
+    *outLen = needed;
+    if (needed >= destSize) {
+        dest[0] = '\0';
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Destination too small for escaped string");
+        return false;
+    }
+    dest[needed] = '\0';
+    return true;
+}
+
+bool SafeEscapeJson(char *dest, size_t destSize, const char *src, size_t srcLen, size_t *outLen) {
+    return EscapeString(ESCAPE_JSON, "NULL pointer in SafeEscapeJson", dest, destSize, src, srcLen, outLen);
+}
+
+bool SafeEscapeHtml(char *dest, size_t destSize, const char *src, size_t srcLen, size_t *outLen) {
+    return EscapeString(ESCAPE_HTML, "NULL pointer in SafeEscapeHtml", dest, destSize, src, srcLen, outLen);
+}
+
+bool SafeEscapeUrl(char *dest, size_t destSize, const char *src, size_t srcLen, size_t *outLen) {
+    return EscapeString(ESCAPE_URL, "NULL pointer in SafeEscapeUrl", dest, destSize, src, srcLen, outLen);
+}
+
+/* ------------------------------------------------------
+   2h) String Interning
+   ------------------------------------------------------ */
+
+/* Open addressing in the SwissTable layout: one control byte per slot holding
+   7 bits of the hash, or INTERN_EMPTY, probed a 16-slot group at a time so a
+   single SSE2 compare filters a whole group. Nothing is ever removed, so
+   there are no tombstones. */
+#define INTERN_GROUP 16
+#define INTERN_EMPTY 0x80
+#define INTERN_BLOCK_SIZE (64 * 1024)
+
+typedef struct InternBlock {
+    struct InternBlock *next;
+    size_t used;
+    size_t size;
+    char data[];
+} InternBlock;
+
+typedef struct {
+    const char *str;
+    size_t len;
+    uint64_t hash;
+} InternEntry;
+
+#ifdef _WIN32
+typedef SRWLOCK InternLock;
+#define INTERN_LOCK_INIT(l) InitializeSRWLock(l)
+#define INTERN_LOCK_DESTROY(l) ((void)(l))
+#define INTERN_READ_LOCK(l) AcquireSRWLockShared(l)
+#define INTERN_READ_UNLOCK(l) ReleaseSRWLockShared(l)
+#define INTERN_WRITE_LOCK(l) AcquireSRWLockExclusive(l)
+#define INTERN_WRITE_UNLOCK(l) ReleaseSRWLockExclusive(l)
+#else
+typedef pthread_rwlock_t InternLock;
+#define INTERN_LOCK_INIT(l) pthread_rwlock_init(l, NULL)
+#define INTERN_LOCK_DESTROY(l) pthread_rwlock_destroy(l)
+#define INTERN_READ_LOCK(l) pthread_rwlock_rdlock(l)
+#define INTERN_READ_UNLOCK(l) pthread_rwlock_unlock(l)
+#define INTERN_WRITE_LOCK(l) pthread_rwlock_wrlock(l)
+#define INTERN_WRITE_UNLOCK(l) pthread_rwlock_unlock(l)
+#endif
+
+struct SafeInternTable {
+    unsigned char *ctrl;      /* capacity control bytes */
+    uint32_t *slots;          /* Entry index for each full control byte */
+    size_t groupMask;         /* Group count - 1 */
+    InternEntry *entries;     /* Indexed by id */
+    size_t count;
+    size_t entryCapacity;
+    InternBlock *arena;       /* Head block has the free space */
+    bool concurrent;
+    InternLock lock;
+};
+
+static uint64_t InternMix(uint64_t h, uint64_t w) {
+    h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+    return h ^ (h >> 32);
+}
+
+/* 8 bytes per multiply, with overlapping loads for the tail instead of a
+   variable-length copy, finished with the MurmurHash3 avalanche so both the
+   group index (low bits) and the control tag (high bits) are well mixed */
+static uint64_t InternHash(const unsigned char *s, size_t len) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ ((uint64_t)len * 0xC2B2AE3D27D4EB4FULL);
+    uint64_t w;
+    uint32_t a, b;
+    if (len >= 8) {
+        for (size_t i = 0; len - i > 8; i += 8) {
+            memcpy(&w, s + i, 8);
+            h = InternMix(h, w);
+        }
+        memcpy(&w, s + len - 8, 8);
+        h = InternMix(h, w);
+    } else if (len >= 4) {
+        memcpy(&a, s, 4);
+        memcpy(&b, s + len - 4, 4);
+        h = InternMix(h, (uint64_t)a << 32 | b);
+    } else if (len > 0) {
+        h = InternMix(h, (uint64_t)s[0] << 16 | (uint64_t)s[len >> 1] << 8 | s[len - 1]);
+    }
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static unsigned char InternTag(uint64_t hash) {
+    return (unsigned char)(hash >> 57);
+}
+
+/* Bit i set when control byte i of the group equals tag */
+static uint32_t InternGroupMatch(const unsigned char *group, unsigned char tag) {
+#ifdef SAFEOPS_HAVE_SSE2
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)tag)));
+#else
+    uint32_t mask = 0;
+    for (unsigned i = 0; i < INTERN_GROUP; i++) {
+        mask |= (uint32_t)(group[i] == tag) << i;
+    }
+    return mask;
+#endif
+}
+
+/* Index of the matching entry, or SIZE_MAX; *outGroup is the first group
+   with an empty slot, where the string would be inserted */
+static size_t InternProbe(const SafeInternTable *table, const char *str, size_t len,
+                          uint64_t hash, size_t *outGroup) {
+    unsigned char tag = InternTag(hash);
+    size_t g = (size_t)hash & table->groupMask;
+    for (size_t step = 1;; step++) {
+        const unsigned char *group = table->ctrl + g * INTERN_GROUP;
+        uint32_t match = InternGroupMatch(group, tag);
+        while (match) {
+            unsigned i = CountTrailingZeros(match);
+            const InternEntry *e = &table->entries[table->slots[g * INTERN_GROUP + i]];
+            if (e->hash == hash && e->len == len && memcmp(e->str, str, len) == 0) {
+                return table->slots[g * INTERN_GROUP + i];
+            }
+            match &= match - 1;
+        }
+        if (InternGroupMatch(group, INTERN_EMPTY)) {
+            if (outGroup) {
+                *outGroup = g;
+            }
+            return SIZE_MAX;
+        }
+        /* Triangular probing visits every group of a power-of-two table */
+        g = (g + step) & table->groupMask;
+    }
+}
+
+static void InternPlace(SafeInternTable *table, size_t g, uint64_t hash, uint32_t id) {
+    unsigned char *group = table->ctrl + g * INTERN_GROUP;
+    unsigned i = CountTrailingZeros(InternGroupMatch(group, INTERN_EMPTY));
+    group[i] = InternTag(hash);
+    table->slots[g * INTERN_GROUP + i] = id;
+}
+
+static bool InternAllocGroups(SafeInternTable *table, size_t groups) {
+    unsigned char *ctrl = (unsigned char *)SafeMallocUninitialized(groups * INTERN_GROUP);
+    uint32_t *slots = (uint32_t *)SafeMallocUninitialized(groups * INTERN_GROUP * sizeof(uint32_t));
+    if (!ctrl || !slots) {
+        SafeFree((void**)&ctrl);
+        SafeFree((void**)&slots);
+        return false;
+    }
+    memset(ctrl, INTERN_EMPTY, groups * INTERN_GROUP);
+    SafeFree((void**)&table->ctrl);
+    SafeFree((void**)&table->slots);
+    table->ctrl = ctrl;
+    table->slots = slots;
+    table->groupMask = groups - 1;
+    return true;
+}
+
+/* Doubles the group count and reinserts every entry from its stored hash */
+static bool InternGrow(SafeInternTable *table) {
+    size_t groups = (table->groupMask + 1) * 2;
+    if (groups > SIZE_MAX / (INTERN_GROUP * sizeof(uint32_t))) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Intern table size would overflow");
+        return false;
+    }
+    if (!InternAllocGroups(table, groups)) {
+        return false;
+    }
+    for (size_t id = 0; id < table->count; id++) {
+        uint64_t hash = table->entries[id].hash;
+        size_t g = (size_t)hash & table->groupMask;
+        for (size_t step = 1; !InternGroupMatch(table->ctrl + g * INTERN_GROUP, INTERN_EMPTY); step++) {
+            g = (g + step) & table->groupMask;
+        }
+        InternPlace(table, g, hash, (uint32_t)id);
+    }
+    return true;
+}
+
+/* Copies len bytes plus a NUL into the arena; the copy never moves */
+static const char* InternStore(SafeInternTable *table, const char *str, size_t len) {
+    InternBlock *block = table->arena;
+    if (!block || block->size - block->used < len + 1) {
+        size_t size = (len + 1 > INTERN_BLOCK_SIZE / 4) ? len + 1 : INTERN_BLOCK_SIZE;
+        if (size > SIZE_MAX - sizeof(InternBlock)) {
+            SetError(SAFEOPS_ERR_OVERFLOW, "Interned string too large");
+            return NULL;
+        }
+        InternBlock *fresh = (InternBlock *)SafeMallocUninitialized(sizeof(InternBlock) + size);
+        if (!fresh) {
+            return NULL;
+        }
+        fresh->used = 0;
+        fresh->size = size;
+        if (block && size != INTERN_BLOCK_SIZE) {
+            /* Oversized strings get a private block behind the head, which
+               keeps its free space for the short strings that follow */
+            fresh->next = block->next;
+            block->next = fresh;
+        } else {
+            fresh->next = block;
+            table->arena = fresh;
+        }
+        block = fresh;
+    }
+    char *copy = block->data + block->used;
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    block->used += len + 1;
+    return copy;
+}
+
+static const char* InternInsert(SafeInternTable *table, const char *str, size_t len,
+                                uint64_t hash, uint32_t *outId) {
+    size_t g;
+    size_t found = InternProbe(table, str, len, hash, &g);
+    if (found != SIZE_MAX) {
+        if (outId) *outId = (uint32_t)found;
+        return table->entries[found].str;
+    }
+    if (table->count >= UINT32_MAX) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Intern table is full");
+        return NULL;
+    }
+
+    /* Keep the load factor at or below 7/8 */
+    size_t capacity = (table->groupMask + 1) * INTERN_GROUP;
+    if (table->count + 1 > capacity - capacity / 8) {
+        if (!InternGrow(table)) {
+            return NULL;
+        }
+        InternProbe(table, str, len, hash, &g);
+    }
+    if (table->count == table->entryCapacity) {
+        size_t newCapacity = table->entryCapacity * 2;
+        if (newCapacity > SIZE_MAX / sizeof(InternEntry)) {
+            SetError(SAFEOPS_ERR_OVERFLOW, "Intern table size would overflow");
+            return NULL;
+        }
+        InternEntry *entries = (InternEntry *)SafeMallocUninitialized(newCapacity * sizeof(InternEntry));
+        if (!entries) {
+            return NULL;
+        }
+        memcpy(entries, table->entries, table->count * sizeof(InternEntry));
+        SafeFree((void**)&table->entries);
+        table->entries = entries;
+        table->entryCapacity = newCapacity;
+    }
+
+    const char *copy = InternStore(table, str, len);
+    if (!copy) {
+        return NULL;
+    }
+    uint32_t id = (uint32_t)table->count++;
+    table->entries[id].str = copy;
+    table->entries[id].len = len;
+    table->entries[id].hash = hash;
+    InternPlace(table, g, hash, id);
+    if (outId) *outId = id;
+    return copy;
+}
+
+SafeInternTable* SafeStrInternCreate(size_t expectedCount, unsigned int flags) {
+    if (expectedCount > UINT32_MAX || expectedCount > SIZE_MAX / (4 * sizeof(InternEntry))) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Expected count exceeds the id range");
+        return NULL;
+    }
+
+    SafeInternTable *table = (SafeInternTable *)SafeMalloc(sizeof(*table));
+    if (!table) {
+        return NULL;
+    }
+
+    /* Smallest power-of-two group count that holds expectedCount under 7/8 load */
+    size_t groups = 1;
+    while ((groups * INTERN_GROUP) - (groups * INTERN_GROUP) / 8 < expectedCount) {
+        groups <<= 1;
+    }
+    table->entryCapacity = expectedCount > 16 ? expectedCount : 16;
+    table->entries = (InternEntry *)SafeMallocUninitialized(table->entryCapacity * sizeof(InternEntry));
+    if (!table->entries || !InternAllocGroups(table, groups)) {
+        SafeFree((void**)&table->entries);
+        SafeFree((void**)&table);
+        return NULL;
+    }
+
+    table->concurrent = (flags & SAFE_INTERN_CONCURRENT) != 0;
+    if (table->concurrent) {
+        INTERN_LOCK_INIT(&table->lock);
+    }
+    return table;
+}
+
+const char* SafeStrIntern(SafeInternTable *table, const char *str, size_t len, uint32_t *outId) {
+    if (!table || !str) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeStrIntern");
+        return NULL;
+    }
+
+    uint64_t hash = InternHash((const unsigned char *)str, len);
+    if (!table->concurrent) {
+        return InternInsert(table, str, len, hash, outId);
+    }
+
+    /* Hits, the common case, only need the shared lock */
+    INTERN_READ_LOCK(&table->lock);
+    size_t found = InternProbe(table, str, len, hash, NULL);
+    const char *result = (found != SIZE_MAX) ? table->entries[found].str : NULL;
+    INTERN_READ_UNLOCK(&table->lock);
+    if (result) {
+        if (outId) *outId = (uint32_t)found;
+        return result;
+    }
+
+    /* Another thread may insert it between the locks; InternInsert re-probes */
+    INTERN_WRITE_LOCK(&table->lock);
+    result = InternInsert(table, str, len, hash, outId);
+    INTERN_WRITE_UNLOCK(&table->lock);
+    return result;
+}
+
+const char* SafeStrInternFind(SafeInternTable *table, const char *str, size_t len, uint32_t *outId) {
+    if (!table || !str) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeStrInternFind");
+        return NULL;
+    }
+
+    uint64_t hash = InternHash((const unsigned char *)str, len);
+    if (table->concurrent) INTERN_READ_LOCK(&table->lock);
+    size_t found = InternProbe(table, str, len, hash, NULL);
+    const char *result = (found != SIZE_MAX) ? table->entries[found].str : NULL;
+    if (table->concurrent) INTERN_READ_UNLOCK(&table->lock);
+    if (result && outId) {
+        *outId = (uint32_t)found;
+    }
+    return result;
+}
+
+const char* SafeStrInternGet(SafeInternTable *table, uint32_t id, size_t *outLen) {
+    if (!table) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeStrInternGet");
+        return NULL;
+    }
+
+    const char *result = NULL;
+    if (table->concurrent) INTERN_READ_LOCK(&table->lock);
+    if (id < table->count) {
+        result = table->entries[id].str;
+        if (outLen) *outLen = table->entries[id].len;
+    }
+    if (table->concurrent) INTERN_READ_UNLOCK(&table->lock);
+    if (!result) {
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Unknown intern id");
+    }
+    return result;
+}
+
+size_t SafeStrInternCount(SafeInternTable *table) {
+    if (!table) {
+        return 0;
+    }
+    if (table->concurrent) INTERN_READ_LOCK(&table->lock);
+    size_t count = table->count;
+    if (table->concurrent) INTERN_READ_UNLOCK(&table->lock);
+    return count;
+}
+
+void SafeStrInternDestroy(SafeInternTable **tableRef) {
+    if (!tableRef || !*tableRef) {
+        return;
+    }
+
+    SafeInternTable *table = *tableRef;
+    *tableRef = NULL;
+
+    InternBlock *block = table->arena;
+    while (block) {
+        InternBlock *next = block->next;
+        SafeFree((void**)&block);
+        block = next;
+    }
+    if (table->concurrent) {
+        INTERN_LOCK_DESTROY(&table->lock);
+    }
+    SafeFree((void**)&table->ctrl);
+    SafeFree((void**)&table->slots);
+    SafeFree((void**)&table->entries);
+    SafeFree((void**)&table);
+}
+
+/* ------------------------------------------------------
+   3) Safe Indexed Read/Write
+   ------------------------------------------------------ */
+
+bool SafeWriteInt(int *array, size_t arraySize, size_t index, int value)
+{
+    SAFE_RETURN_VAL_IF_FAIL(array, false);
+    SAFE_RETURN_VAL_IF_FAIL(index < arraySize, false);
+
+    array[index] = value;
+    return true;
+}
+
+bool SafeReadInt(const int *array, size_t arraySize, size_t index, int *outValue)
+{
+    SAFE_RETURN_VAL_IF_FAIL(array && outValue, false);
+    SAFE_RETURN_VAL_IF_FAIL(index < arraySize, false);
+
+    *outValue = array[index];
+    return true;
+}
+
+/* ------------------------------------------------------
+   4) Safe Pointer Offsets
+   ------------------------------------------------------ */
+
+void* SafePointerOffset(void *base, size_t baseSize, size_t offset)
+{
+    SAFE_RETURN_VAL_IF_FAIL(base, NULL);
+
+    /* Check for overflow in pointer arithmetic */
+    if (offset > baseSize ||
+        (uintptr_t)base + offset < (uintptr_t)base) {
+        errno = EOVERFLOW;
+        return NULL;
+    }
+
+    return (char*)base + offset;
+}
+
+/* ------------------------------------------------------
+   5) Safe Arithmetic
+   ------------------------------------------------------ */
+
+bool SafeAddInt(int a, int b, int *result)
+{
+    SAFE_RETURN_VAL_IF_FAIL(result, false);
+
+    /* Use GCC/Clang builtin if available */
+#if defined(__GNUC__) || defined(__clang__)
+    if (__builtin_sadd_overflow(a, b, result)) {
+            errno = EOVERFLOW;
+            return false;
+        }
+#else
+    if ((b > 0 && a > INT_MAX - b) ||
+        (b < 0 && a < INT_MIN - b)) {
+        errno = EOVERFLOW;
+        return false;
+    }
+    *result = a + b;
+#endif
+
+    return true;
+}
+
+bool SafeCastLongLongToInt(long long val, int *out)
+{
+    SAFE_RETURN_VAL_IF_FAIL(out, false);
+
+    if (val > INT_MAX || val < INT_MIN) {
+        errno = EOVERFLOW;
+        return false;
+    }
+
+    *out = (int)val;
+    return true;
+}
+
+/* ------------------------------------------------------
+   5a) Numeric Parsing
+   ------------------------------------------------------ */
+
+typedef enum {
+    PARSE_OK,
+    PARSE_INVALID,
+    PARSE_OVERFLOW
+} ParseStatus;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define SAFEOPS_LITTLE_ENDIAN 1
+#elif defined(_WIN32) || defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SAFEOPS_LITTLE_ENDIAN 1
+#endif
+
+#ifdef SAFEOPS_LITTLE_ENDIAN
+/* All eight bytes of a little-endian load are '0'..'9' */
+static bool IsEightDigits(uint64_t v) {
+    return (((v & 0xF0F0F0F0F0F0F0F0ULL) |
+             (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL);
+}
+
+/* Eight ASCII digits to their value in three multiplies (SWAR) */
+static uint32_t ParseEightDigits(uint64_t v) {
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 100 + (1000000ULL << 32);
+    const uint64_t mul2 = 1 + (10000ULL << 32);
+    v -= 0x3030303030303030ULL;
+    v = (v * 10) + (v >> 8);
+    v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+    return (uint32_t)v;
+}
+#endif
+
+/* Unsigned decimal digits only, the whole span. Up to 16 digits are taken
+   eight at a time; only the last few can overflow and are checked one by one. */
+static ParseStatus ParseDecimalDigits(const unsigned char *s, size_t len, uint64_t *outValue) {
+    if (len == 0) {
+        return PARSE_INVALID;
+    }
+    while (len > 1 && s[0] == '0') {
+        s++;
+        len--;
+    }
+
+    uint64_t value = 0;
+    size_t i = 0;
+#ifdef SAFEOPS_LITTLE_ENDIAN
+    while (len - i >= 8 && i < 16) {
+        uint64_t chunk;
+        memcpy(&chunk, s + i, 8);
+        if (!IsEightDigits(chunk)) {
+            break;
+        }
+        value = value * 100000000ULL + ParseEightDigits(chunk);
+        i += 8;
+    }
+#endif
+
+    bool overflow = false;
+    for (; i < len; i++) {
+        unsigned d = (unsigned)(s[i] - '0');
+        if (d > 9) {
+            return PARSE_INVALID;  /* Syntax errors win over overflow */
+        }
+        if (value > (UINT64_MAX - d) / 10) {
+            overflow = true;
+        }
+        value = value * 10 + d;
+    }
+    if (overflow) {
+        return PARSE_OVERFLOW;
+    }
+    *outValue = value;
+    return PARSE_OK;
+}
+
+/* Optional sign, then digits; magnitude is checked against the caller's limits */
+static ParseStatus ParseSignedMagnitude(const char *str, size_t len, bool allowMinus,
+                                        bool *outNegative, uint64_t *outMagnitude) {
+    const unsigned char *s = (const unsigned char *)str;
+    *outNegative = false;
+    if (len > 0 && (s[0] == '+' || s[0] == '-')) {
+        if (s[0] == '-') {
+            if (!allowMinus) {
+                return PARSE_INVALID;
+            }
+            *outNegative = true;
+        }
+        s++;
+        len--;
+    }
+    return ParseDecimalDigits(s, len, outMagnitude);
+}
+
+static bool ParseIntegerResult(ParseStatus status, const char *name) {
+    if (status == PARSE_INVALID) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, name);
+        return false;
+    }
+    if (status == PARSE_OVERFLOW) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Number out of range");
+        return false;
+    }
+    return true;
+}
+
+bool SafeParseInt64(const char *str, size_t len, int64_t *out) {
+    if (!str || !out) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeParseInt64");
+        return false;
+    }
+
+    bool negative;
+    uint64_t magnitude = 0;
+    ParseStatus status = ParseSignedMagnitude(str, len, true, &negative, &magnitude);
+    if (status == PARSE_OK && magnitude > (uint64_t)INT64_MAX + (negative ? 1u : 0u)) {
+        status = PARSE_OVERFLOW;
+    }
+    if (!ParseIntegerResult(status, "Not a decimal integer")) {
+        return false;
+    }
+
+    *out = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+    return true;
+}
+
+bool SafeParseInt32(const char *str, size_t len, int32_t *out) {
+    if (!str || !out) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeParseInt32");
+        return false;
+    }
+
+    bool negative;
+    uint64_t magnitude = 0;
+    ParseStatus status = ParseSignedMagnitude(str, len, true, &negative, &magnitude);
+    if (status == PARSE_OK && magnitude > (uint64_t)INT32_MAX + (negative ? 1u : 0u)) {
+        status = PARSE_OVERFLOW;
+    }
+    if (!ParseIntegerResult(status, "Not a decimal integer")) {
+        return false;
+    }
+
+    *out = negative ? (int32_t)(0 - (int64_t)magnitude) : (int32_t)magnitude;
+    return true;
+}
+
+bool SafeParseUInt64(const char *str, size_t len, uint64_t *out) {
+    if (!str || !out) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeParseUInt64");
+        return false;
+    }
+
+    bool negative;
+    uint64_t magnitude = 0;
+    ParseStatus status = ParseSignedMagnitude(str, len, false, &negative, &magnitude);
+    if (!ParseIntegerResult(status, "Not an unsigned decimal integer")) {
+        return false;
+    }
+
+    *out = magnitude;
+    return true;
+}
+
+static bool MatchesNoCase(const char *s, size_t len, const char *word) {
+    size_t wordLen = strlen(word);
+    if (len != wordLen) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (AsciiLower((unsigned char)s[i]) != (unsigned char)word[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* strtod on a NUL-terminated copy, with '.' swapped for the locale's radix
+   character so the result does not depend on setlocale */
+static ParseStatus ParseDoubleSlow(const char *str, size_t len, double *out) {
+    const char *radix = localeconv()->decimal_point;
+    size_t radixLen = (radix && radix[0]) ? strlen(radix) : 1;
+    if (!radix || !radix[0]) {
+        radix = ".";
+    }
+
+    char stackBuf[128];
+    size_t need = len + radixLen + 1;
+    char *copy = (need <= sizeof(stackBuf)) ? stackBuf : (char *)SafeMallocUninitialized(need);
+    if (!copy) {
+        return PARSE_INVALID;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (str[i] == '.') {
+            memcpy(copy + n, radix, radixLen);
+            n += radixLen;
+        } else {
+            copy[n++] = str[i];
+        }
+    }
+    copy[n] = '\0';
+
+    char *end;
+    errno = 0;
+    double value = strtod(copy, &end);
+    bool consumed = (end == copy + n);
+    bool overflow = (errno == ERANGE && (value == HUGE_VAL || value == -HUGE_VAL));
+    if (copy != stackBuf) {
+        SafeFree((void**)&copy);
+    }
+
+    if (!consumed) {
+        return PARSE_INVALID;
+    }
+    if (overflow) {
+        return PARSE_OVERFLOW;
+    }
+    *out = value;  /* Underflow yields the nearest representable value */
+    return PARSE_OK;
+}
+
+bool SafeParseDouble(const char *str, size_t len, double *out) {
+    if (!str || !out) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeParseDouble");
+        return false;
+    }
+
+    /* Validate the grammar ourselves: [+-] digits [. digits] [(e|E) [+-] digits] */
+    const unsigned char *s = (const unsigned char *)str;
+    size_t i = 0;
+    bool negative = false;
+    if (i < len && (s[i] == '+' || s[i] == '-')) {
+        negative = (s[i] == '-');
+        i++;
+    }
+
+    if (MatchesNoCase(str + i, len - i, "inf") || MatchesNoCase(str + i, len - i, "infinity")) {
+        *out = negative ? -HUGE_VAL : HUGE_VAL;
+        return true;
+    }
+    if (MatchesNoCase(str + i, len - i, "nan")) {
+        *out = negative ? -NAN : NAN;
+        return true;
+    }
+
+    uint64_t mantissa = 0;
+    int significant = 0;     /* Digits accumulated into mantissa */
+    long dropped = 0;        /* Integer digits beyond the 19 that fit */
+    long fracDigits = 0;
+    size_t digits = 0;
+
+    for (; i < len && (unsigned)(s[i] - '0') <= 9; i++, digits++) {
+        if (significant < 19) {
+            if (mantissa || s[i] != '0') {
+                mantissa = mantissa * 10 + (unsigned)(s[i] - '0');
+                significant += (mantissa != 0);
+            }
+        } else {
+            dropped++;
+        }
+    }
+    if (i < len && s[i] == '.') {
+        i++;
+        for (; i < len && (unsigned)(s[i] - '0') <= 9; i++, digits++) {
+            if (significant < 19) {
+                if (mantissa || s[i] != '0') {
+                    mantissa = mantissa * 10 + (unsigned)(s[i] - '0');
+                    significant += (mantissa != 0);
+                }
+                fracDigits++;
+            } else if (s[i] != '0') {
+                dropped = -1;  /* Inexact: leave it to strtod */
+            }
+        }
+    }
+    if (digits == 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Not a decimal number");
+        return false;
+    }
+
+    long exponent = 0;
+    if (i < len && (s[i] == 'e' || s[i] == 'E')) {
+        i++;
+        bool expNegative = false;
+        if (i < len && (s[i] == '+' || s[i] == '-')) {
+            expNegative = (s[i] == '-');
+            i++;
+        }
+        size_t expStart = i;
+        for (; i < len && (unsigned)(s[i] - '0') <= 9; i++) {
+            if (exponent < 100000) {
+                exponent = exponent * 10 + (s[i] - '0');
+            }
+        }
+        if (i == expStart) {
+            SetError(SAFEOPS_ERR_INVALID_PARAM, "Not a decimal number");
+            return false;
+        }
+        if (expNegative) {
+            exponent = -exponent;
+        }
+    }
+    if (i != len) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Not a decimal number");
+        return false;
+    }
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+    /* Clinger's fast path: an exact mantissa times an exact power of ten
+       rounds once, so the result is correctly rounded */
+    static const double powersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    long scale = exponent - fracDigits;
+    if (dropped == 0 && mantissa <= (1ULL << 53) && scale >= -22 && scale <= 22) {
+        double value = (double)mantissa;
+        value = (scale < 0) ? value / powersOfTen[-scale] : value * powersOfTen[scale];
+        *out = negative ? -value : value;
+        return true;
+    }
+    if (mantissa == 0) {
+        *out = negative ? -0.0 : 0.0;
+        return true;
+    }
+#endif
+
+    ParseStatus status = ParseDoubleSlow(str, len, out);
+    if (status == PARSE_OVERFLOW) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Number out of range");
+        return false;
+    }
+    if (status != PARSE_OK) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Not a decimal number");
+        return false;
+    }
+    return true;
+}
+
+/* ------------------------------------------------------
+   6) Safe Printf
+   ------------------------------------------------------ */
+
+/* Argument a conversion consumes, after default promotions */
+typedef enum {
+    FMT_ARG_NONE,        /* Literal text */
+    FMT_ARG_INT,
+    FMT_ARG_LONG,
+    FMT_ARG_LLONG,
+    FMT_ARG_SIZE,        /* z: size_t, or its signed counterpart */
+    FMT_ARG_INTMAX,
+    FMT_ARG_PTRDIFF,
+    FMT_ARG_DOUBLE,
+    FMT_ARG_LONG_DOUBLE,
+    FMT_ARG_STRING,
+    FMT_ARG_WSTRING,
+    FMT_ARG_WINT,
+    FMT_ARG_POINTER
+} FormatArg;
+
+typedef struct {
+    FormatArg arg;
+    char conversion;      /* 'd', 'x', 's', ...; 0 for literal text */
+    unsigned char stars;  /* int arguments taken first by '*' width/precision */
+    bool simple;          /* No flags, width, precision or h/hh */
+    size_t textOffset;    /* Literal text or NUL-terminated spec in the pool */
+    size_t textLen;
+} FormatOp;
+
+/* Parses the conversion starting at the '%' in spec and returns its length.
+   0 rejects anything printf leaves undefined, positional arguments, and %n,
+   which writes through a pointer argument. "%%" is literal text. */
+static size_t ParseConversion(const char *spec, FormatOp *op) {
+    const char *p = spec + 1;
+    bool plain = true;
+
+    op->stars = 0;
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0' || *p == '\'') {
+        p++;
+        plain = false;
+    }
+    if (*p == '*') {
+        op->stars++;
+        p++;
+        plain = false;
+    }
+    while ((unsigned)(*p - '0') <= 9) {
+        p++;
+        plain = false;
+    }
+    if (*p == '.') {
+        p++;
+        plain = false;
+        if (*p == '*') {
+            op->stars++;
+            p++;
+        }
+        while ((unsigned)(*p - '0') <= 9) {
+            p++;
+        }
+    }
+
+    char length = 0;  /* 'H' for hh, 'q' for ll */
+    if (*p == 'h' || *p == 'l') {
+        length = *p++;
+        if (*p == length) {
+            length = (length == 'h') ? 'H' : 'q';
+            p++;
+        }
+    } else if (*p == 'j' || *p == 'z' || *p == 't' || *p == 'L') {
+        length = *p++;
+    }
+
+    char conversion = *p;
+    switch (conversion) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            switch (length) {
+                case 0: case 'h': case 'H': op->arg = FMT_ARG_INT; break;
+                case 'l': op->arg = FMT_ARG_LONG; break;
+                case 'q': op->arg = FMT_ARG_LLONG; break;
+                case 'j': op->arg = FMT_ARG_INTMAX; break;
+                case 'z': op->arg = FMT_ARG_SIZE; break;
+                case 't': op->arg = FMT_ARG_PTRDIFF; break;
+                default: return 0;
+            }
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if (length == 0 || length == 'l') op->arg = FMT_ARG_DOUBLE;
+            else if (length == 'L') op->arg = FMT_ARG_LONG_DOUBLE;
+            else return 0;
+            break;
+        case 'c':
+            if (length == 0) op->arg = FMT_ARG_INT;
+            else if (length == 'l') op->arg = FMT_ARG_WINT;
+            else return 0;
+            break;
+        case 's':
+            if (length == 0) op->arg = FMT_ARG_STRING;
+            else if (length == 'l') op->arg = FMT_ARG_WSTRING;
+            else return 0;
+            break;
+        case 'p':
+            if (length != 0) return 0;
+            op->arg = FMT_ARG_POINTER;
+            break;
+        default:
+            return 0;
+    }
+
+    op->conversion = conversion;
+    op->simple = plain && length != 'h' && length != 'H' && conversion != 'o' && conversion != 'X' &&
+                 op->arg != FMT_ARG_DOUBLE && op->arg != FMT_ARG_LONG_DOUBLE && op->arg != FMT_ARG_POINTER &&
+                 op->arg != FMT_ARG_WINT && op->arg != FMT_ARG_WSTRING;
+    return (size_t)(p - spec) + 1;
+}
+
+static bool ValidateFormat(const char *format) {
+    for (const char *p = strchr(format, '%'); p; ) {
+        if (p[1] == '%') {
+            p = strchr(p + 2, '%');
+            continue;
+        }
+        FormatOp op;
+        size_t specLen = ParseConversion(p, &op);
+        if (specLen == 0) {
+            SetError(SAFEOPS_ERR_INVALID_PARAM, "Unsupported or unsafe printf conversion");
+            return false;
+        }
+        p = strchr(p + specLen, '%');
+    }
+    return true;
+}
+
+/* Whole output or nothing: a result that does not fit leaves str empty */
+static int FinishPrint(char *str, size_t size, int needed) {
+    if (needed < 0) {
+        str[0] = '\0';
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Formatting failed");
+        return -1;
+    }
+    if ((size_t)needed >= size) {
+        str[0] = '\0';
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Formatted output truncated");
+        return -1;
+    }
+    return needed;
+}
+
+/* Per-thread buffered output, section 6c */
+static bool PrintIsBuffered(void);
+static int BufferedVPrintf(const char *format, va_list args);
+static int BufferedWrite(const char *text, size_t len);
+
+int SafePrintf(const char *format, ...)
+{
+    SAFE_RETURN_VAL_IF_FAIL(format, -1);
+    if (!ValidateFormat(format)) {
+        return -1;
+    }
+
+    va_list args;
+            va_start(args, format);
+    int ret = PrintIsBuffered() ? BufferedVPrintf(format, args) : vprintf(format, args);
+            va_end(args);
+
+    return ret;
+}
+
+int SafeSnprintf(char *str, size_t size, const char *format, ...)
+{
+    if (!str || !format) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeSnprintf");
+        return -1;
+    }
+    if (size == 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Destination size is 0");
+        return -1;
+    }
+    if (!ValidateFormat(format)) {
+        str[0] = '\0';
+        return -1;
+    }
+
+    va_list args;
+    va_start(args, format);
+    int ret = vsnprintf(str, size, format, args);
+    va_end(args);
+
+    return FinishPrint(str, size, ret);
+}
+
+/* ------------------------------------------------------
+   6a) Number Formatting
+   ------------------------------------------------------ */
+
+/* "00".."99": integers are emitted two digits per division */
+static const char g_digitPairs[201] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+/* Writes value's decimal digits so they end just before end; returns the first digit */
+static char *WriteDigitsBackward(char *end, uint64_t value) {
+    while (value >= 100) {
+        size_t pair = (size_t)(value % 100) * 2;
+        value /= 100;
+        end -= 2;
+        memcpy(end, g_digitPairs + pair, 2);
+    }
+    if (value >= 10) {
+        end -= 2;
+        memcpy(end, g_digitPairs + value * 2, 2);
+    } else {
+        *--end = (char)('0' + value);
+    }
+    return end;
+}
+
+/* Lowercase hex counterpart of WriteDigitsBackward */
+static char *WriteHexBackward(char *end, uint64_t value) {
+    static const char hexDigits[] = "0123456789abcdef";
+    do {
+        *--end = hexDigits[value & 0xF];
+        value >>= 4;
+    } while (value);
+    return end;
+}
+
+/* Copies formatted text into dest with the same conventions as the UTF
+   transcoders: dest NULL only reports the length, too small leaves it empty */
+static bool FinishFormat(const char *text, size_t len, char *dest, size_t destSize, size_t *outWritten) {
+    if (!outWritten) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in number formatting");
+        return false;
+    }
+    *outWritten = len;
+    if (!dest) {
+        return true;
+    }
+    if (destSize == 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Destination size is 0");
+        return false;
+    }
+    if (len >= destSize) {
+        dest[0] = '\0';
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Destination too small for formatted number");
+        return false;
+    }
+    memcpy(dest, text, len);
+    dest[len] = '\0';
+    return true;
+}
+
+bool SafeFmtUInt(char *dest, size_t destSize, uint64_t value, size_t *outWritten) {
+    char buf[24];
+    char *start = WriteDigitsBackward(buf + sizeof(buf), value);
+    return FinishFormat(start, (size_t)(buf + sizeof(buf) - start), dest, destSize, outWritten);
+}
+
+bool SafeFmtInt(char *dest, size_t destSize, int64_t value, size_t *outWritten) {
+    char buf[24];
+    /* Negate in unsigned arithmetic so INT64_MIN is fine */
+    uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    char *start = WriteDigitsBackward(buf + sizeof(buf), magnitude);
+    if (value < 0) {
+        *--start = '-';
+    }
+    return FinishFormat(start, (size_t)(buf + sizeof(buf) - start), dest, destSize, outWritten);
+}
+
+bool SafeFmtHex(char *dest, size_t destSize, uint64_t value, size_t *outWritten) {
+    char buf[16];
+    char *start = WriteHexBackward(buf + sizeof(buf), value);
+    return FinishFormat(start, (size_t)(buf + sizeof(buf) - start), dest, destSize, outWritten);
+}
+
+/* Shortest round-trip doubles follow Ulf Adams' Ryu (PLDI 2018): the rounding
+   interval of the double is scaled into decimal with one 64x128-bit multiply
+   per bound, then digits are dropped while both bounds still agree.
+   g_ryuPow5InvSplit[q] = floor(2^(bitlen(5^q) - 1 + 125) / 5^q) + 1 and
+   g_ryuPow5Split[i] = 5^i normalised to 125 bits, each stored as { low, high }. */
+#define RYU_POW5_INV_BITCOUNT 125
+#define RYU_POW5_BITCOUNT 125
+
+static const uint64_t g_ryuPow5InvSplit[342][2] = {
+    { 1ULL, 2305843009213693952ULL }, { 11068046444225730970ULL, 1844674407370955161ULL },
+    { 5165088340638674453ULL, 1475739525896764129ULL }, { 7821419487252849886ULL, 1180591620717411303ULL },
+    { 8824922364862649494ULL, 1888946593147858085ULL }, { 7059937891890119595ULL, 1511157274518286468ULL },
+    { 13026647942995916322ULL, 1208925819614629174ULL }, { 9774590264567735146ULL, 1934281311383406679ULL },
+    { 11509021026396098440ULL, 1547425049106725343ULL }, { 16585914450600699399ULL, 1237940039285380274ULL },
+    { 15469416676735388068ULL, 1980704062856608439ULL }, { 16064882156130220778ULL, 1584563250285286751ULL },
+    { 9162556910162266299ULL, 1267650600228229401ULL }, { 7281393426775805432ULL, 2028240960365167042ULL },
+    { 16893161185646375315ULL, 1622592768292133633ULL }, { 2446482504291369283ULL, 1298074214633706907ULL },
+    { 7603720821608101175ULL, 2076918743413931051ULL }, { 2393627842544570617ULL, 1661534994731144841ULL },
+    { 16672297533003297786ULL, 1329227995784915872ULL }, { 11918280793837635165ULL, 2126764793255865396ULL },
+    { 5845275820328197809ULL, 1701411834604692317ULL }, { 15744267100488289217ULL, 1361129467683753853ULL },
+    { 3054734472329800808ULL, 2177807148294006166ULL }, { 17201182836831481939ULL, 1742245718635204932ULL },
+    { 6382248639981364905ULL, 1393796574908163946ULL }, { 2832900194486363201ULL, 2230074519853062314ULL },
+    { 5955668970331000884ULL, 1784059615882449851ULL }, { 1075186361522890384ULL, 1427247692705959881ULL },
+    { 12788344622662355584ULL, 2283596308329535809ULL }, { 13920024512871794791ULL, 1826877046663628647ULL },
+    { 3757321980813615186ULL, 1461501637330902918ULL }, { 10384555214134712795ULL, 1169201309864722334ULL },
+    { 5547241898389809503ULL, 1870722095783555735ULL }, { 4437793518711847602ULL, 1496577676626844588ULL },
+    { 10928932444453298728ULL, 1197262141301475670ULL }, { 17486291911125277965ULL, 1915619426082361072ULL },
+    { 6610335899416401726ULL, 1532495540865888858ULL }, { 12666966349016942027ULL, 1225996432692711086ULL },
+    { 12888448528943286597ULL, 1961594292308337738ULL }, { 17689456452638449924ULL, 1569275433846670190ULL },
+    { 14151565162110759939ULL, 1255420347077336152ULL }, { 7885109000409574610ULL, 2008672555323737844ULL },
+    { 9997436015069570011ULL, 1606938044258990275ULL }, { 7997948812055656009ULL, 1285550435407192220ULL },
+    { 12796718099289049614ULL, 2056880696651507552ULL }, { 2858676849947419045ULL, 1645504557321206042ULL },
+    { 13354987924183666206ULL, 1316403645856964833ULL }, { 17678631863951955605ULL, 2106245833371143733ULL },
+    { 3074859046935833515ULL, 1684996666696914987ULL }, { 13527933681774397782ULL, 1347997333357531989ULL },
+    { 10576647446613305481ULL, 2156795733372051183ULL }, { 15840015586774465031ULL, 1725436586697640946ULL },
+    { 8982663654677661702ULL, 1380349269358112757ULL }, { 18061610662226169046ULL, 2208558830972980411ULL },
+    { 10759939715039024913ULL, 1766847064778384329ULL }, { 12297300586773130254ULL, 1413477651822707463ULL },
+    { 15986332124095098083ULL, 2261564242916331941ULL }, { 9099716884534168143ULL, 1809251394333065553ULL },
+    { 14658471137111155161ULL, 1447401115466452442ULL }, { 4348079280205103483ULL, 1157920892373161954ULL },
+    { 14335624477811986218ULL, 1852673427797059126ULL }, { 7779150767507678651ULL, 1482138742237647301ULL },
+    { 2533971799264232598ULL, 1185710993790117841ULL }, { 15122401323048503126ULL, 1897137590064188545ULL },
+    { 12097921058438802501ULL, 1517710072051350836ULL }, { 5988988032009131678ULL, 1214168057641080669ULL },
+    { 16961078480698431330ULL, 1942668892225729070ULL }, { 13568862784558745064ULL, 1554135113780583256ULL },
+    { 7165741412905085728ULL, 1243308091024466605ULL }, { 11465186260648137165ULL, 1989292945639146568ULL },
+    { 16550846638002330379ULL, 1591434356511317254ULL }, { 16930026125143774626ULL, 1273147485209053803ULL },
+    { 4951948911778577463ULL, 2037035976334486086ULL }, { 272210314680951647ULL, 1629628781067588869ULL },
+    { 3907117066486671641ULL, 1303703024854071095ULL }, { 6251387306378674625ULL, 2085924839766513752ULL },
+    { 16069156289328670670ULL, 1668739871813211001ULL }, { 9165976216721026213ULL, 1334991897450568801ULL },
+    { 7286864317269821294ULL, 2135987035920910082ULL }, { 16897537898041588005ULL, 1708789628736728065ULL },
+    { 13518030318433270404ULL, 1367031702989382452ULL }, { 6871453250525591353ULL, 2187250724783011924ULL },
+    { 9186511415162383406ULL, 1749800579826409539ULL }, { 11038557946871817048ULL, 1399840463861127631ULL },
+    { 10282995085511086630ULL, 2239744742177804210ULL }, { 8226396068408869304ULL, 1791795793742243368ULL },
+    { 13959814484210916090ULL, 1433436634993794694ULL }, { 11267656730511734774ULL, 2293498615990071511ULL },
+    { 5324776569667477496ULL, 1834798892792057209ULL }, { 7949170070475892320ULL, 1467839114233645767ULL },
+    { 17427382500606444826ULL, 1174271291386916613ULL }, { 5747719112518849781ULL, 1878834066219066582ULL },
+    { 15666221734240810795ULL, 1503067252975253265ULL }, { 12532977387392648636ULL, 1202453802380202612ULL },
+    { 5295368560860596524ULL, 1923926083808324180ULL }, { 4236294848688477220ULL, 1539140867046659344ULL },
+    { 7078384693692692099ULL, 1231312693637327475ULL }, { 11325415509908307358ULL, 1970100309819723960ULL },
+    { 9060332407926645887ULL, 1576080247855779168ULL }, { 14626963555825137356ULL, 1260864198284623334ULL },
+    { 12335095245094488799ULL, 2017382717255397335ULL }, { 9868076196075591040ULL, 1613906173804317868ULL },
+    { 15273158586344293478ULL, 1291124939043454294ULL }, { 13369007293925138595ULL, 2065799902469526871ULL },
+    { 7005857020398200553ULL, 1652639921975621497ULL }, { 16672732060544291412ULL, 1322111937580497197ULL },
+    { 11918976037903224966ULL, 2115379100128795516ULL }, { 5845832015580669650ULL, 1692303280103036413ULL },
+    { 12055363241948356366ULL, 1353842624082429130ULL }, { 841837113407818570ULL, 2166148198531886609ULL },
+    { 4362818505468165179ULL, 1732918558825509287ULL }, { 14558301248600263113ULL, 1386334847060407429ULL },
+    { 12225235553534690011ULL, 2218135755296651887ULL }, { 2401490813343931363ULL, 1774508604237321510ULL },
+    { 1921192650675145090ULL, 1419606883389857208ULL }, { 17831303500047873437ULL, 2271371013423771532ULL },
+    { 6886345170554478103ULL, 1817096810739017226ULL }, { 1819727321701672159ULL, 1453677448591213781ULL },
+    { 16213177116328979020ULL, 1162941958872971024ULL }, { 14873036941900635463ULL, 1860707134196753639ULL },
+    { 15587778368262418694ULL, 1488565707357402911ULL }, { 8780873879868024632ULL, 1190852565885922329ULL },
+    { 2981351763563108441ULL, 1905364105417475727ULL }, { 13453127855076217722ULL, 1524291284333980581ULL },
+    { 7073153469319063855ULL, 1219433027467184465ULL }, { 11317045550910502167ULL, 1951092843947495144ULL },
+    { 12742985255470312057ULL, 1560874275157996115ULL }, { 10194388204376249646ULL, 1248699420126396892ULL },
+    { 1553625868034358140ULL, 1997919072202235028ULL }, { 8621598323911307159ULL, 1598335257761788022ULL },
+    { 17965325103354776697ULL, 1278668206209430417ULL }, { 13987124906400001422ULL, 2045869129935088668ULL },
+    { 121653480894270168ULL, 1636695303948070935ULL }, { 97322784715416134ULL, 1309356243158456748ULL },
+    { 14913111714512307107ULL, 2094969989053530796ULL }, { 8241140556867935363ULL, 1675975991242824637ULL },
+    { 17660958889720079260ULL, 1340780792994259709ULL }, { 17189487779326395846ULL, 2145249268790815535ULL },
+    { 13751590223461116677ULL, 1716199415032652428ULL }, { 18379969808252713988ULL, 1372959532026121942ULL },
+    { 14650556434236701088ULL, 2196735251241795108ULL }, { 652398703163629901ULL, 1757388200993436087ULL },
+    { 11589965406756634890ULL, 1405910560794748869ULL }, { 7475898206584884855ULL, 2249456897271598191ULL },
+    { 2291369750525997561ULL, 1799565517817278553ULL }, { 9211793429904618695ULL, 1439652414253822842ULL },
+    { 18428218302589300235ULL, 2303443862806116547ULL }, { 7363877012587619542ULL, 1842755090244893238ULL },
+    { 13269799239553916280ULL, 1474204072195914590ULL }, { 10615839391643133024ULL, 1179363257756731672ULL },
+    { 2227947767661371545ULL, 1886981212410770676ULL }, { 16539753473096738529ULL, 1509584969928616540ULL },
+    { 13231802778477390823ULL, 1207667975942893232ULL }, { 6413489186596184024ULL, 1932268761508629172ULL },
+    { 16198837793502678189ULL, 1545815009206903337ULL }, { 5580372605318321905ULL, 1236652007365522670ULL },
+    { 8928596168509315048ULL, 1978643211784836272ULL }, { 18210923379033183008ULL, 1582914569427869017ULL },
+    { 7190041073742725760ULL, 1266331655542295214ULL }, { 436019273762630246ULL, 2026130648867672343ULL },
+    { 7727513048493924843ULL, 1620904519094137874ULL }, { 9871359253537050198ULL, 1296723615275310299ULL },
+    { 4726128361433549347ULL, 2074757784440496479ULL }, { 7470251503888749801ULL, 1659806227552397183ULL },
+    { 13354898832594820487ULL, 1327844982041917746ULL }, { 13989140502667892133ULL, 2124551971267068394ULL },
+    { 14880661216876224029ULL, 1699641577013654715ULL }, { 11904528973500979224ULL, 1359713261610923772ULL },
+    { 4289851098633925465ULL, 2175541218577478036ULL }, { 18189276137874781665ULL, 1740432974861982428ULL },
+    { 3483374466074094362ULL, 1392346379889585943ULL }, { 1884050330976640656ULL, 2227754207823337509ULL },
+    { 5196589079523222848ULL, 1782203366258670007ULL }, { 15225317707844309248ULL, 1425762693006936005ULL },
+    { 5913764258841343181ULL, 2281220308811097609ULL }, { 8420360221814984868ULL, 1824976247048878087ULL },
+    { 17804334621677718864ULL, 1459980997639102469ULL }, { 17932816512084085415ULL, 1167984798111281975ULL },
+    { 10245762345624985047ULL, 1868775676978051161ULL }, { 4507261061758077715ULL, 1495020541582440929ULL },
+    { 7295157664148372495ULL, 1196016433265952743ULL }, { 7982903447895485668ULL, 1913626293225524389ULL },
+    { 10075671573058298858ULL, 1530901034580419511ULL }, { 4371188443704728763ULL, 1224720827664335609ULL },
+    { 14372599139411386667ULL, 1959553324262936974ULL }, { 15187428126271019657ULL, 1567642659410349579ULL },
+    { 15839291315758726049ULL, 1254114127528279663ULL }, { 3206773216762499739ULL, 2006582604045247462ULL },
+    { 13633465017635730761ULL, 1605266083236197969ULL }, { 14596120828850494932ULL, 1284212866588958375ULL },
+    { 4907049252451240275ULL, 2054740586542333401ULL }, { 236290587219081897ULL, 1643792469233866721ULL },
+    { 14946427728742906810ULL, 1315033975387093376ULL }, { 16535586736504830250ULL, 2104054360619349402ULL },
+    { 5849771759720043554ULL, 1683243488495479522ULL }, { 15747863852001765813ULL, 1346594790796383617ULL },
+    { 10439186904235184007ULL, 2154551665274213788ULL }, { 15730047152871967852ULL, 1723641332219371030ULL },
+    { 12584037722297574282ULL, 1378913065775496824ULL }, { 9066413911450387881ULL, 2206260905240794919ULL },
+    { 10942479943902220628ULL, 1765008724192635935ULL }, { 8753983955121776503ULL, 1412006979354108748ULL },
+    { 10317025513452932081ULL, 2259211166966573997ULL }, { 874922781278525018ULL, 1807368933573259198ULL },
+    { 8078635854506640661ULL, 1445895146858607358ULL }, { 13841606313089133175ULL, 1156716117486885886ULL },
+    { 14767872471458792434ULL, 1850745787979017418ULL }, { 746251532941302978ULL, 1480596630383213935ULL },
+    { 597001226353042382ULL, 1184477304306571148ULL }, { 15712597221132509104ULL, 1895163686890513836ULL },
+    { 8880728962164096960ULL, 1516130949512411069ULL }, { 10793931984473187891ULL, 1212904759609928855ULL },
+    { 17270291175157100626ULL, 1940647615375886168ULL }, { 2748186495899949531ULL, 1552518092300708935ULL },
+    { 2198549196719959625ULL, 1242014473840567148ULL }, { 18275073973719576693ULL, 1987223158144907436ULL },
+    { 10930710364233751031ULL, 1589778526515925949ULL }, { 12433917106128911148ULL, 1271822821212740759ULL },
+    { 8826220925580526867ULL, 2034916513940385215ULL }, { 7060976740464421494ULL, 1627933211152308172ULL },
+    { 16716827836597268165ULL, 1302346568921846537ULL }, { 11989529279587987770ULL, 2083754510274954460ULL },
+    { 9591623423670390216ULL, 1667003608219963568ULL }, { 15051996368420132820ULL, 1333602886575970854ULL },
+    { 13015147745246481542ULL, 2133764618521553367ULL }, { 3033420566713364587ULL, 1707011694817242694ULL },
+    { 6116085268112601993ULL, 1365609355853794155ULL }, { 9785736428980163188ULL, 2184974969366070648ULL },
+    { 15207286772667951197ULL, 1747979975492856518ULL }, { 1097782973908629988ULL, 1398383980394285215ULL },
+    { 1756452758253807981ULL, 2237414368630856344ULL }, { 5094511021344956708ULL, 1789931494904685075ULL },
+    { 4075608817075965366ULL, 1431945195923748060ULL }, { 6520974107321544586ULL, 2291112313477996896ULL },
+    { 1527430471115325346ULL, 1832889850782397517ULL }, { 12289990821117991246ULL, 1466311880625918013ULL },
+    { 17210690286378213644ULL, 1173049504500734410ULL }, { 9090360384495590213ULL, 1876879207201175057ULL },
+    { 18340334751822203140ULL, 1501503365760940045ULL }, { 14672267801457762512ULL, 1201202692608752036ULL },
+    { 16096930852848599373ULL, 1921924308174003258ULL }, { 1809498238053148529ULL, 1537539446539202607ULL },
+    { 12515645034668249793ULL, 1230031557231362085ULL }, { 1578287981759648052ULL, 1968050491570179337ULL },
+    { 12330676829633449412ULL, 1574440393256143469ULL }, { 13553890278448669853ULL, 1259552314604914775ULL },
+    { 3239480371808320148ULL, 2015283703367863641ULL }, { 17348979556414297411ULL, 1612226962694290912ULL },
+    { 6500486015647617283ULL, 1289781570155432730ULL }, { 10400777625036187652ULL, 2063650512248692368ULL },
+    { 15699319729512770768ULL, 1650920409798953894ULL }, { 16248804598352126938ULL, 1320736327839163115ULL },
+    { 7551343283653851484ULL, 2113178124542660985ULL }, { 6041074626923081187ULL, 1690542499634128788ULL },
+    { 12211557331022285596ULL, 1352433999707303030ULL }, { 1091747655926105338ULL, 2163894399531684849ULL },
+    { 4562746939482794594ULL, 1731115519625347879ULL }, { 7339546366328145998ULL, 1384892415700278303ULL },
+    { 8053925371383123274ULL, 2215827865120445285ULL }, { 6443140297106498619ULL, 1772662292096356228ULL },
+    { 12533209867169019542ULL, 1418129833677084982ULL }, { 5295740528502789974ULL, 2269007733883335972ULL },
+    { 15304638867027962949ULL, 1815206187106668777ULL }, { 4865013464138549713ULL, 1452164949685335022ULL },
+    { 14960057215536570740ULL, 1161731959748268017ULL }, { 9178696285890871890ULL, 1858771135597228828ULL },
+    { 14721654658196518159ULL, 1487016908477783062ULL }, { 4398626097073393881ULL, 1189613526782226450ULL },
+    { 7037801755317430209ULL, 1903381642851562320ULL }, { 5630241404253944167ULL, 1522705314281249856ULL },
+    { 814844308661245011ULL, 1218164251424999885ULL }, { 1303750893857992017ULL, 1949062802279999816ULL },
+    { 15800395974054034906ULL, 1559250241823999852ULL }, { 5261619149759407279ULL, 1247400193459199882ULL },
+    { 12107939454356961969ULL, 1995840309534719811ULL }, { 5997002748743659252ULL, 1596672247627775849ULL },
+    { 8486951013736837725ULL, 1277337798102220679ULL }, { 2511075177753209390ULL, 2043740476963553087ULL },
+    { 13076906586428298482ULL, 1634992381570842469ULL }, { 14150874083884549109ULL, 1307993905256673975ULL },
+    { 4194654460505726958ULL, 2092790248410678361ULL }, { 18113118827372222859ULL, 1674232198728542688ULL },
+    { 3422448617672047318ULL, 1339385758982834151ULL }, { 16543964232501006678ULL, 2143017214372534641ULL },
+    { 9545822571258895019ULL, 1714413771498027713ULL }, { 15015355686490936662ULL, 1371531017198422170ULL },
+    { 5577825024675947042ULL, 2194449627517475473ULL }, { 11840957649224578280ULL, 1755559702013980378ULL },
+    { 16851463748863483271ULL, 1404447761611184302ULL }, { 12204946739213931940ULL, 2247116418577894884ULL },
+    { 13453306206113055875ULL, 1797693134862315907ULL }, { 3383947335406624054ULL, 1438154507889852726ULL },
+    { 16482362180876329456ULL, 2301047212623764361ULL }, { 9496540929959153242ULL, 1840837770099011489ULL },
+    { 11286581558709232917ULL, 1472670216079209191ULL }, { 5339916432225476010ULL, 1178136172863367353ULL },
+    { 4854517476818851293ULL, 1885017876581387765ULL }, { 3883613981455081034ULL, 1508014301265110212ULL },
+    { 14174937629389795797ULL, 1206411441012088169ULL }, { 11611853762797942306ULL, 1930258305619341071ULL },
+    { 5600134195496443521ULL, 1544206644495472857ULL }, { 15548153800622885787ULL, 1235365315596378285ULL },
+    { 6430302007287065643ULL, 1976584504954205257ULL }, { 16212288050055383484ULL, 1581267603963364205ULL },
+    { 12969830440044306787ULL, 1265014083170691364ULL }, { 9683682259845159889ULL, 2024022533073106183ULL },
+    { 15125643437359948558ULL, 1619218026458484946ULL }, { 8411165935146048523ULL, 1295374421166787957ULL },
+    { 17147214310975587960ULL, 2072599073866860731ULL }, { 10028422634038560045ULL, 1658079259093488585ULL },
+    { 8022738107230848036ULL, 1326463407274790868ULL }, { 9147032156827446534ULL, 2122341451639665389ULL },
+    { 11006974540203867551ULL, 1697873161311732311ULL }, { 5116230817421183718ULL, 1358298529049385849ULL },
+    { 15564666937357714594ULL, 2173277646479017358ULL }, { 1383687105660440706ULL, 1738622117183213887ULL },
+    { 12174996128754083534ULL, 1390897693746571109ULL }, { 8411947361780802685ULL, 2225436309994513775ULL },
+    { 6729557889424642148ULL, 1780349047995611020ULL }, { 5383646311539713719ULL, 1424279238396488816ULL },
+    { 1235136468979721303ULL, 2278846781434382106ULL }, { 15745504434151418335ULL, 1823077425147505684ULL },
+    { 16285752362063044992ULL, 1458461940118004547ULL }, { 5649904260166615347ULL, 1166769552094403638ULL },
+    { 5350498001524674232ULL, 1866831283351045821ULL }, { 591049586477829062ULL, 1493465026680836657ULL },
+    { 11540886113407994219ULL, 1194772021344669325ULL }, { 18673707743239135ULL, 1911635234151470921ULL },
+    { 14772334225162232601ULL, 1529308187321176736ULL }, { 8128518565387875758ULL, 1223446549856941389ULL },
+    { 1937583260394870242ULL, 1957514479771106223ULL }, { 8928764237799716840ULL, 1566011583816884978ULL },
+    { 14521709019723594119ULL, 1252809267053507982ULL }, { 8477339172590109297ULL, 2004494827285612772ULL },
+    { 17849917782297818407ULL, 1603595861828490217ULL }, { 6901236596354434079ULL, 1282876689462792174ULL },
+    { 18420676183650915173ULL, 2052602703140467478ULL }, { 3668494502695001169ULL, 1642082162512373983ULL },
+    { 10313493231639821582ULL, 1313665730009899186ULL }, { 9122891541139893884ULL, 2101865168015838698ULL },
+    { 14677010862395735754ULL, 1681492134412670958ULL }, { 673562245690857633ULL, 1345193707530136767ULL }
+};
+
+static const uint64_t g_ryuPow5Split[326][2] = {
+    { 0ULL, 1152921504606846976ULL }, { 0ULL, 1441151880758558720ULL },
+    { 0ULL, 1801439850948198400ULL }, { 0ULL, 2251799813685248000ULL },
+    { 0ULL, 1407374883553280000ULL }, { 0ULL, 1759218604441600000ULL },
+    { 0ULL, 2199023255552000000ULL }, { 0ULL, 1374389534720000000ULL },
+    { 0ULL, 1717986918400000000ULL }, { 0ULL, 2147483648000000000ULL },
+    { 0ULL, 1342177280000000000ULL }, { 0ULL, 1677721600000000000ULL },
+    { 0ULL, 2097152000000000000ULL }, { 0ULL, 1310720000000000000ULL },
+    { 0ULL, 1638400000000000000ULL }, { 0ULL, 2048000000000000000ULL },
+    { 0ULL, 1280000000000000000ULL }, { 0ULL, 1600000000000000000ULL },
+    { 0ULL, 2000000000000000000ULL }, { 0ULL, 1250000000000000000ULL },
+    { 0ULL, 1562500000000000000ULL }, { 0ULL, 1953125000000000000ULL },
+    { 0ULL, 1220703125000000000ULL }, { 0ULL, 1525878906250000000ULL },
+    { 0ULL, 1907348632812500000ULL }, { 0ULL, 1192092895507812500ULL },
+    { 0ULL, 1490116119384765625ULL }, { 4611686018427387904ULL, 1862645149230957031ULL },
+    { 9799832789158199296ULL, 1164153218269348144ULL }, { 12249790986447749120ULL, 1455191522836685180ULL },
+    { 15312238733059686400ULL, 1818989403545856475ULL }, { 14528612397897220096ULL, 2273736754432320594ULL },
+    { 13692068767113150464ULL, 1421085471520200371ULL }, { 12503399940464050176ULL, 1776356839400250464ULL },
+    { 15629249925580062720ULL, 2220446049250313080ULL }, { 9768281203487539200ULL, 1387778780781445675ULL },
+    { 7598665485932036096ULL, 1734723475976807094ULL }, { 274959820560269312ULL, 2168404344971008868ULL },
+    { 9395221924704944128ULL, 1355252715606880542ULL }, { 2520655369026404352ULL, 1694065894508600678ULL },
+    { 12374191248137781248ULL, 2117582368135750847ULL }, { 14651398557727195136ULL, 1323488980084844279ULL },
+    { 13702562178731606016ULL, 1654361225106055349ULL }, { 3293144668132343808ULL, 2067951531382569187ULL },
+    { 18199116482078572544ULL, 1292469707114105741ULL }, { 8913837547316051968ULL, 1615587133892632177ULL },
+    { 15753982952572452864ULL, 2019483917365790221ULL }, { 12152082354571476992ULL, 1262177448353618888ULL },
+    { 15190102943214346240ULL, 1577721810442023610ULL }, { 9764256642163156992ULL, 1972152263052529513ULL },
+    { 17631875447420442880ULL, 1232595164407830945ULL }, { 8204786253993389888ULL, 1540743955509788682ULL },
+    { 1032610780636961552ULL, 1925929944387235853ULL }, { 2951224747111794922ULL, 1203706215242022408ULL },
+    { 3689030933889743652ULL, 1504632769052528010ULL }, { 13834660704216955373ULL, 1880790961315660012ULL },
+    { 17870034976990372916ULL, 1175494350822287507ULL }, { 17725857702810578241ULL, 1469367938527859384ULL },
+    { 3710578054803671186ULL, 1836709923159824231ULL }, { 26536550077201078ULL, 2295887403949780289ULL },
+    { 11545800389866720434ULL, 1434929627468612680ULL }, { 14432250487333400542ULL, 1793662034335765850ULL },
+    { 8816941072311974870ULL, 2242077542919707313ULL }, { 17039803216263454053ULL, 1401298464324817070ULL },
+    { 12076381983474541759ULL, 1751623080406021338ULL }, { 5872105442488401391ULL, 2189528850507526673ULL },
+    { 15199280947623720629ULL, 1368455531567204170ULL }, { 9775729147674874978ULL, 1710569414459005213ULL },
+    { 16831347453020981627ULL, 2138211768073756516ULL }, { 1296220121283337709ULL, 1336382355046097823ULL },
+    { 15455333206886335848ULL, 1670477943807622278ULL }, { 10095794471753144002ULL, 2088097429759527848ULL },
+    { 6309871544845715001ULL, 1305060893599704905ULL }, { 12499025449484531656ULL, 1631326116999631131ULL },
+    { 11012095793428276666ULL, 2039157646249538914ULL }, { 11494245889320060820ULL, 1274473528905961821ULL },
+    { 532749306367912313ULL, 1593091911132452277ULL }, { 5277622651387278295ULL, 1991364888915565346ULL },
+    { 7910200175544436838ULL, 1244603055572228341ULL }, { 14499436237857933952ULL, 1555753819465285426ULL },
+    { 8900923260467641632ULL, 1944692274331606783ULL }, { 12480606065433357876ULL, 1215432671457254239ULL },
+    { 10989071563364309441ULL, 1519290839321567799ULL }, { 9124653435777998898ULL, 1899113549151959749ULL },
+    { 8008751406574943263ULL, 1186945968219974843ULL }, { 5399253239791291175ULL, 1483682460274968554ULL },
+    { 15972438586593889776ULL, 1854603075343710692ULL }, { 759402079766405302ULL, 1159126922089819183ULL },
+    { 14784310654990170340ULL, 1448908652612273978ULL }, { 9257016281882937117ULL, 1811135815765342473ULL },
+    { 16182956370781059300ULL, 2263919769706678091ULL }, { 7808504722524468110ULL, 1414949856066673807ULL },
+    { 5148944884728197234ULL, 1768687320083342259ULL }, { 1824495087482858639ULL, 2210859150104177824ULL },
+    { 1140309429676786649ULL, 1381786968815111140ULL }, { 1425386787095983311ULL, 1727233711018888925ULL },
+    { 6393419502297367043ULL, 2159042138773611156ULL }, { 13219259225790630210ULL, 1349401336733506972ULL },
+    { 16524074032238287762ULL, 1686751670916883715ULL }, { 16043406521870471799ULL, 2108439588646104644ULL },
+    { 803757039314269066ULL, 1317774742903815403ULL }, { 14839754354425000045ULL, 1647218428629769253ULL },
+    { 4714634887749086344ULL, 2059023035787211567ULL }, { 9864175832484260821ULL, 1286889397367007229ULL },
+    { 16941905809032713930ULL, 1608611746708759036ULL }, { 2730638187581340797ULL, 2010764683385948796ULL },
+    { 10930020904093113806ULL, 1256727927116217997ULL }, { 18274212148543780162ULL, 1570909908895272496ULL },
+    { 4396021111970173586ULL, 1963637386119090621ULL }, { 5053356204195052443ULL, 1227273366324431638ULL },
+    { 15540067292098591362ULL, 1534091707905539547ULL }, { 14813398096695851299ULL, 1917614634881924434ULL },
+    { 13870059828862294966ULL, 1198509146801202771ULL }, { 12725888767650480803ULL, 1498136433501503464ULL },
+    { 15907360959563101004ULL, 1872670541876879330ULL }, { 14553786618154326031ULL, 1170419088673049581ULL },
+    { 4357175217410743827ULL, 1463023860841311977ULL }, { 10058155040190817688ULL, 1828779826051639971ULL },
+    { 7961007781811134206ULL, 2285974782564549964ULL }, { 14199001900486734687ULL, 1428734239102843727ULL },
+    { 13137066357181030455ULL, 1785917798878554659ULL }, { 11809646928048900164ULL, 2232397248598193324ULL },
+    { 16604401366885338411ULL, 1395248280373870827ULL }, { 16143815690179285109ULL, 1744060350467338534ULL },
+    { 10956397575869330579ULL, 2180075438084173168ULL }, { 6847748484918331612ULL, 1362547148802608230ULL },
+    { 17783057643002690323ULL, 1703183936003260287ULL }, { 17617136035325974999ULL, 2128979920004075359ULL },
+    { 17928239049719816230ULL, 1330612450002547099ULL }, { 17798612793722382384ULL, 1663265562503183874ULL },
+    { 13024893955298202172ULL, 2079081953128979843ULL }, { 5834715712847682405ULL, 1299426220705612402ULL },
+    { 16516766677914378815ULL, 1624282775882015502ULL }, { 11422586310538197711ULL, 2030353469852519378ULL },
+    { 11750802462513761473ULL, 1268970918657824611ULL }, { 10076817059714813937ULL, 1586213648322280764ULL },
+    { 12596021324643517422ULL, 1982767060402850955ULL }, { 5566670318688504437ULL, 1239229412751781847ULL },
+    { 2346651879933242642ULL, 1549036765939727309ULL }, { 7545000868343941206ULL, 1936295957424659136ULL },
+    { 4715625542714963254ULL, 1210184973390411960ULL }, { 5894531928393704067ULL, 1512731216738014950ULL },
+    { 16591536947346905892ULL, 1890914020922518687ULL }, { 17287239619732898039ULL, 1181821263076574179ULL },
+    { 16997363506238734644ULL, 1477276578845717724ULL }, { 2799960309088866689ULL, 1846595723557147156ULL },
+    { 10973347230035317489ULL, 1154122327223216972ULL }, { 13716684037544146861ULL, 1442652909029021215ULL },
+    { 12534169028502795672ULL, 1803316136286276519ULL }, { 11056025267201106687ULL, 2254145170357845649ULL },
+    { 18439230838069161439ULL, 1408840731473653530ULL }, { 13825666510731675991ULL, 1761050914342066913ULL },
+    { 3447025083132431277ULL, 2201313642927583642ULL }, { 6766076695385157452ULL, 1375821026829739776ULL },
+    { 8457595869231446815ULL, 1719776283537174720ULL }, { 10571994836539308519ULL, 2149720354421468400ULL },
+    { 6607496772837067824ULL, 1343575221513417750ULL }, { 17482743002901110588ULL, 1679469026891772187ULL },
+    { 17241742735199000331ULL, 2099336283614715234ULL }, { 15387775227926763111ULL, 1312085177259197021ULL },
+    { 5399660979626290177ULL, 1640106471573996277ULL }, { 11361262242960250625ULL, 2050133089467495346ULL },
+    { 11712474920277544544ULL, 1281333180917184591ULL }, { 10028907631919542777ULL, 1601666476146480739ULL },
+    { 7924448521472040567ULL, 2002083095183100924ULL }, { 14176152362774801162ULL, 1251301934489438077ULL },
+    { 3885132398186337741ULL, 1564127418111797597ULL }, { 9468101516160310080ULL, 1955159272639746996ULL },
+    { 15140935484454969608ULL, 1221974545399841872ULL }, { 479425281859160394ULL, 1527468181749802341ULL },
+    { 5210967620751338397ULL, 1909335227187252926ULL }, { 17091912818251750210ULL, 1193334516992033078ULL },
+    { 12141518985959911954ULL, 1491668146240041348ULL }, { 15176898732449889943ULL, 1864585182800051685ULL },
+    { 11791404716994875166ULL, 1165365739250032303ULL }, { 10127569877816206054ULL, 1456707174062540379ULL },
+    { 8047776328842869663ULL, 1820883967578175474ULL }, { 836348374198811271ULL, 2276104959472719343ULL },
+    { 7440246761515338900ULL, 1422565599670449589ULL }, { 13911994470321561530ULL, 1778206999588061986ULL },
+    { 8166621051047176104ULL, 2222758749485077483ULL }, { 2798295147690791113ULL, 1389224218428173427ULL },
+    { 17332926989895652603ULL, 1736530273035216783ULL }, { 17054472718942177850ULL, 2170662841294020979ULL },
+    { 8353202440125167204ULL, 1356664275808763112ULL }, { 10441503050156459005ULL, 1695830344760953890ULL },
+    { 3828506775840797949ULL, 2119787930951192363ULL }, { 86973725686804766ULL, 1324867456844495227ULL },
+    { 13943775212390669669ULL, 1656084321055619033ULL }, { 3594660960206173375ULL, 2070105401319523792ULL },
+    { 2246663100128858359ULL, 1293815875824702370ULL }, { 12031700912015848757ULL, 1617269844780877962ULL },
+    { 5816254103165035138ULL, 2021587305976097453ULL }, { 5941001823691840913ULL, 1263492066235060908ULL },
+    { 7426252279614801142ULL, 1579365082793826135ULL }, { 4671129331091113523ULL, 1974206353492282669ULL },
+    { 5225298841145639904ULL, 1233878970932676668ULL }, { 6531623551432049880ULL, 1542348713665845835ULL },
+    { 3552843420862674446ULL, 1927935892082307294ULL }, { 16055585193321335241ULL, 1204959932551442058ULL },
+    { 10846109454796893243ULL, 1506199915689302573ULL }, { 18169322836923504458ULL, 1882749894611628216ULL },
+    { 11355826773077190286ULL, 1176718684132267635ULL }, { 9583097447919099954ULL, 1470898355165334544ULL },
+    { 11978871809898874942ULL, 1838622943956668180ULL }, { 14973589762373593678ULL, 2298278679945835225ULL },
+    { 2440964573842414192ULL, 1436424174966147016ULL }, { 3051205717303017741ULL, 1795530218707683770ULL },
+    { 13037379183483547984ULL, 2244412773384604712ULL }, { 8148361989677217490ULL, 1402757983365377945ULL },
+    { 14797138505523909766ULL, 1753447479206722431ULL }, { 13884737113477499304ULL, 2191809349008403039ULL },
+    { 15595489723564518921ULL, 1369880843130251899ULL }, { 14882676136028260747ULL, 1712351053912814874ULL },
+    { 9379973133180550126ULL, 2140438817391018593ULL }, { 17391698254306313589ULL, 1337774260869386620ULL },
+    { 3292878744173340370ULL, 1672217826086733276ULL }, { 4116098430216675462ULL, 2090272282608416595ULL },
+    { 266718509671728212ULL, 1306420176630260372ULL }, { 333398137089660265ULL, 1633025220787825465ULL },
+    { 5028433689789463235ULL, 2041281525984781831ULL }, { 10060300083759496378ULL, 1275800953740488644ULL },
+    { 12575375104699370472ULL, 1594751192175610805ULL }, { 1884160825592049379ULL, 1993438990219513507ULL },
+    { 17318501580490888525ULL, 1245899368887195941ULL }, { 7813068920331446945ULL, 1557374211108994927ULL },
+    { 5154650131986920777ULL, 1946717763886243659ULL }, { 915813323278131534ULL, 1216698602428902287ULL },
+    { 14979824709379828129ULL, 1520873253036127858ULL }, { 9501408849870009354ULL, 1901091566295159823ULL },
+    { 12855909558809837702ULL, 1188182228934474889ULL }, { 2234828893230133415ULL, 1485227786168093612ULL },
+    { 2793536116537666769ULL, 1856534732710117015ULL }, { 8663489100477123587ULL, 1160334207943823134ULL },
+    { 1605989338741628675ULL, 1450417759929778918ULL }, { 11230858710281811652ULL, 1813022199912223647ULL },
+    { 9426887369424876662ULL, 2266277749890279559ULL }, { 12809333633531629769ULL, 1416423593681424724ULL },
+    { 16011667041914537212ULL, 1770529492101780905ULL }, { 6179525747111007803ULL, 2213161865127226132ULL },
+    { 13085575628799155685ULL, 1383226165704516332ULL }, { 16356969535998944606ULL, 1729032707130645415ULL },
+    { 15834525901571292854ULL, 2161290883913306769ULL }, { 2979049660840976177ULL, 1350806802445816731ULL },
+    { 17558870131333383934ULL, 1688508503057270913ULL }, { 8113529608884566205ULL, 2110635628821588642ULL },
+    { 9682642023980241782ULL, 1319147268013492901ULL }, { 16714988548402690132ULL, 1648934085016866126ULL },
+    { 11670363648648586857ULL, 2061167606271082658ULL }, { 11905663298832754689ULL, 1288229753919426661ULL },
+    { 1047021068258779650ULL, 1610287192399283327ULL }, { 15143834390605638274ULL, 2012858990499104158ULL },
+    { 4853210475701136017ULL, 1258036869061940099ULL }, { 1454827076199032118ULL, 1572546086327425124ULL },
+    { 1818533845248790147ULL, 1965682607909281405ULL }, { 3442426662494187794ULL, 1228551629943300878ULL },
+    { 13526405364972510550ULL, 1535689537429126097ULL }, { 3072948650933474476ULL, 1919611921786407622ULL },
+    { 15755650962115585259ULL, 1199757451116504763ULL }, { 15082877684217093670ULL, 1499696813895630954ULL },
+    { 9630225068416591280ULL, 1874621017369538693ULL }, { 8324733676974063502ULL, 1171638135855961683ULL },
+    { 5794231077790191473ULL, 1464547669819952104ULL }, { 7242788847237739342ULL, 1830684587274940130ULL },
+    { 18276858095901949986ULL, 2288355734093675162ULL }, { 16034722328366106645ULL, 1430222333808546976ULL },
+    { 1596658836748081690ULL, 1787777917260683721ULL }, { 6607509564362490017ULL, 2234722396575854651ULL },
+    { 1823850468512862308ULL, 1396701497859909157ULL }, { 6891499104068465790ULL, 1745876872324886446ULL },
+    { 17837745916940358045ULL, 2182346090406108057ULL }, { 4231062170446641922ULL, 1363966306503817536ULL },
+    { 5288827713058302403ULL, 1704957883129771920ULL }, { 6611034641322878003ULL, 2131197353912214900ULL },
+    { 13355268687681574560ULL, 1331998346195134312ULL }, { 16694085859601968200ULL, 1664997932743917890ULL },
+    { 11644235287647684442ULL, 2081247415929897363ULL }, { 4971804045566108824ULL, 1300779634956185852ULL },
+    { 6214755056957636030ULL, 1625974543695232315ULL }, { 3156757802769657134ULL, 2032468179619040394ULL },
+    { 6584659645158423613ULL, 1270292612261900246ULL }, { 17454196593302805324ULL, 1587865765327375307ULL },
+    { 17206059723201118751ULL, 1984832206659219134ULL }, { 6142101308573311315ULL, 1240520129162011959ULL },
+    { 3065940617289251240ULL, 1550650161452514949ULL }, { 8444111790038951954ULL, 1938312701815643686ULL },
+    { 665883850346957067ULL, 1211445438634777304ULL }, { 832354812933696334ULL, 1514306798293471630ULL },
+    { 10263815553021896226ULL, 1892883497866839537ULL }, { 17944099766707154901ULL, 1183052186166774710ULL },
+    { 13206752671529167818ULL, 1478815232708468388ULL }, { 16508440839411459773ULL, 1848519040885585485ULL },
+    { 12623618533845856310ULL, 1155324400553490928ULL }, { 15779523167307320387ULL, 1444155500691863660ULL },
+    { 1277659885424598868ULL, 1805194375864829576ULL }, { 1597074856780748586ULL, 2256492969831036970ULL },
+    { 5609857803915355770ULL, 1410308106144398106ULL }, { 16235694291748970521ULL, 1762885132680497632ULL },
+    { 1847873790976661535ULL, 2203606415850622041ULL }, { 12684136165428883219ULL, 1377254009906638775ULL },
+    { 11243484188358716120ULL, 1721567512383298469ULL }, { 219297180166231438ULL, 2151959390479123087ULL },
+    { 7054589765244976505ULL, 1344974619049451929ULL }, { 13429923224983608535ULL, 1681218273811814911ULL },
+    { 12175718012802122765ULL, 2101522842264768639ULL }, { 14527352785642408584ULL, 1313451776415480399ULL },
+    { 13547504963625622826ULL, 1641814720519350499ULL }, { 12322695186104640628ULL, 2052268400649188124ULL },
+    { 16925056528170176201ULL, 1282667750405742577ULL }, { 7321262604930556539ULL, 1603334688007178222ULL },
+    { 18374950293017971482ULL, 2004168360008972777ULL }, { 4566814905495150320ULL, 1252605225005607986ULL },
+    { 14931890668723713708ULL, 1565756531257009982ULL }, { 9441491299049866327ULL, 1957195664071262478ULL },
+    { 1289246043478778550ULL, 1223247290044539049ULL }, { 6223243572775861092ULL, 1529059112555673811ULL },
+    { 3167368447542438461ULL, 1911323890694592264ULL }, { 1979605279714024038ULL, 1194577431684120165ULL },
+    { 7086192618069917952ULL, 1493221789605150206ULL }, { 18081112809442173248ULL, 1866527237006437757ULL },
+    { 13606538515115052232ULL, 1166579523129023598ULL }, { 7784801107039039482ULL, 1458224403911279498ULL },
+    { 507629346944023544ULL, 1822780504889099373ULL }, { 5246222702107417334ULL, 2278475631111374216ULL },
+    { 3278889188817135834ULL, 1424047269444608885ULL }, { 8710297504448807696ULL, 1780059086805761106ULL }
+};
+
+/* ceil(log2(5^e)) for 0 <= e <= 3528, 1 for e == 0 */
+static int32_t RyuPow5Bits(int32_t e) {
+    return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+/* floor(log10(2^e)) and floor(log10(5^e)) for small non-negative e */
+static uint32_t RyuLog10Pow2(int32_t e) {
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+static uint32_t RyuLog10Pow5(int32_t e) {
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+static bool RyuMultipleOfPow5(uint64_t value, uint32_t p) {
+    uint32_t count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count >= p;
+}
+
+static bool RyuMultipleOfPow2(uint64_t value, uint32_t p) {
+    return (value & ((1ULL << p) - 1)) == 0;
+}
+
+/* (m * mul) >> j where mul is 128 bits and 64 < j < 128 */
+static uint64_t RyuMulShift(uint64_t m, const uint64_t *mul, int32_t j) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 low = (unsigned __int128)m * mul[0];
+    unsigned __int128 high = (unsigned __int128)m * mul[1];
+    return (uint64_t)(((low >> 64) + high) >> (j - 64));
+#else
+    uint64_t products[2][2];
+    for (int k = 0; k < 2; k++) {
+        uint64_t a = m, b = mul[k];
+        uint64_t p00 = (a & 0xFFFFFFFFu) * (b & 0xFFFFFFFFu);
+        uint64_t p01 = (a & 0xFFFFFFFFu) * (b >> 32);
+        uint64_t p10 = (a >> 32) * (b & 0xFFFFFFFFu);
+        uint64_t p11 = (a >> 32) * (b >> 32);
+        uint64_t mid1 = p10 + (p00 >> 32);
+        uint64_t mid2 = p01 + (mid1 & 0xFFFFFFFFu);
+        products[k][1] = p11 + (mid1 >> 32) + (mid2 >> 32);
+        products[k][0] = (mid2 << 32) | (p00 & 0xFFFFFFFFu);
+    }
+    uint64_t sumLow = products[1][0] + products[0][1];
+    uint64_t sumHigh = products[1][1] + (sumLow < products[0][1]);
+    int32_t shift = j - 64;
+    return (sumHigh << (64 - shift)) | (sumLow >> shift);
+#endif
+}
+
+/* Shortest decimal (*outMantissa * 10^*outExponent) that rounds back to the
+   finite, non-zero double with the given IEEE fields */
+static void RyuShortest(uint64_t ieeeMantissa, uint32_t ieeeExponent,
+                        uint64_t *outMantissa, int32_t *outExponent) {
+    int32_t e2;
+    uint64_t m2;
+    /* Two extra bits so the interval bounds are integers */
+    if (ieeeExponent == 0) {
+        e2 = 1 - 1023 - 52 - 2;
+        m2 = ieeeMantissa;
+    } else {
+        e2 = (int32_t)ieeeExponent - 1023 - 52 - 2;
+        m2 = (1ULL << 52) | ieeeMantissa;
+    }
+    bool acceptBounds = (m2 & 1) == 0;  /* Round-half-even reading includes ties */
+
+    /* Interval [mm, mp] around mv = 4*m2; the lower gap halves at powers of two */
+    uint64_t mv = 4 * m2;
+    uint32_t mmShift = (ieeeMantissa != 0 || ieeeExponent <= 1);
+
+    uint64_t vr, vp, vm;
+    int32_t e10;
+    bool vmIsTrailingZeros = false;
+    bool vrIsTrailingZeros = false;
+    if (e2 >= 0) {
+        uint32_t q = RyuLog10Pow2(e2) - (e2 > 3);
+        e10 = (int32_t)q;
+        int32_t k = RYU_POW5_INV_BITCOUNT + RyuPow5Bits((int32_t)q) - 1;
+        int32_t i = -e2 + (int32_t)q + k;
+        vr = RyuMulShift(4 * m2, g_ryuPow5InvSplit[q], i);
+        vp = RyuMulShift(4 * m2 + 2, g_ryuPow5InvSplit[q], i);
+        vm = RyuMulShift(4 * m2 - 1 - mmShift, g_ryuPow5InvSplit[q], i);
+        if (q <= 21) {
+            /* At most one of mm, mv, mp can be a multiple of 5 */
+            if (mv % 5 == 0) {
+                vrIsTrailingZeros = RyuMultipleOfPow5(mv, q);
+            } else if (acceptBounds) {
+                vmIsTrailingZeros = RyuMultipleOfPow5(mv - 1 - mmShift, q);
+            } else {
+                vp -= RyuMultipleOfPow5(mv + 2, q);
+            }
+        }
+    } else {
+        uint32_t q = RyuLog10Pow5(-e2) - (-e2 > 1);
+        e10 = (int32_t)q + e2;
+        int32_t i = -e2 - (int32_t)q;
+        int32_t k = RyuPow5Bits(i) - RYU_POW5_BITCOUNT;
+        int32_t j = (int32_t)q - k;
+        vr = RyuMulShift(4 * m2, g_ryuPow5Split[i], j);
+        vp = RyuMulShift(4 * m2 + 2, g_ryuPow5Split[i], j);
+        vm = RyuMulShift(4 * m2 - 1 - mmShift, g_ryuPow5Split[i], j);
+        if (q <= 1) {
+            /* mv always has two trailing zero bits, mm has one iff mmShift */
+            vrIsTrailingZeros = true;
+            if (acceptBounds) {
+                vmIsTrailingZeros = (mmShift == 1);
+            } else {
+                --vp;
+            }
+        } else if (q < 63) {
+            vrIsTrailingZeros = RyuMultipleOfPow2(mv, q);
+        }
+    }
+
+    /* Drop digits while the interval still contains a shorter number */
+    int32_t removed = 0;
+    uint64_t output;
+    if (vmIsTrailingZeros || vrIsTrailingZeros) {
+        uint32_t lastRemovedDigit = 0;
+        while (vp / 10 > vm / 10) {
+            vmIsTrailingZeros &= (vm % 10 == 0);
+            vrIsTrailingZeros &= (lastRemovedDigit == 0);
+            lastRemovedDigit = (uint32_t)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vmIsTrailingZeros) {
+            while (vm % 10 == 0) {
+                vrIsTrailingZeros &= (lastRemovedDigit == 0);
+                lastRemovedDigit = (uint32_t)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0) {
+            lastRemovedDigit = 4;  /* Exactly halfway: round to even */
+        }
+        output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5);
+    } else {
+        bool roundUp = false;
+        if (vp / 100 > vm / 100) {
+            roundUp = (vr % 100) >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            roundUp = (vr % 10) >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || roundUp);
+    }
+    *outMantissa = output;
+    *outExponent = e10 + removed;
+}
+
+/* Prints like %g with exactly as many digits as needed: plain notation for
+   decimal exponents -4..16, otherwise d.ddde[+-]XX. Non-finite values print as
+   inf, -inf and nan, all of which SafeParseDouble reads back. */
+bool SafeFmtDouble(char *dest, size_t destSize, double value, size_t *outWritten) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bool negative = (bits >> 63) != 0;
+    uint64_t ieeeMantissa = bits & ((1ULL << 52) - 1);
+    uint32_t ieeeExponent = (uint32_t)((bits >> 52) & 0x7FF);
+
+    char buf[32];
+    size_t len = 0;
+    if (ieeeExponent == 0x7FF && ieeeMantissa != 0) {
+        return FinishFormat("nan", 3, dest, destSize, outWritten);
+    }
+    if (negative) {
+        buf[len++] = '-';
+    }
+    if (ieeeExponent == 0x7FF) {
+        memcpy(buf + len, "inf", 3);
+        return FinishFormat(buf, len + 3, dest, destSize, outWritten);
+    }
+    if (ieeeExponent == 0 && ieeeMantissa == 0) {
+        buf[len++] = '0';
+        return FinishFormat(buf, len, dest, destSize, outWritten);
+    }
+
+    uint64_t mantissa;
+    int32_t exponent;
+    RyuShortest(ieeeMantissa, ieeeExponent, &mantissa, &exponent);
+
+    char digitBuf[20];
+    char *digits = WriteDigitsBackward(digitBuf + sizeof(digitBuf), mantissa);
+    int32_t digitCount = (int32_t)(digitBuf + sizeof(digitBuf) - digits);
+    int32_t sciExponent = exponent + digitCount - 1;
+
+    if (sciExponent >= -4 && sciExponent < 17) {
+        if (exponent >= 0) {
+            /* Integral: digits then zeros, at most 17 characters */
+            memcpy(buf + len, digits, (size_t)digitCount);
+            len += (size_t)digitCount;
+            memset(buf + len, '0', (size_t)exponent);
+            len += (size_t)exponent;
+        } else if (sciExponent >= 0) {
+            size_t intDigits = (size_t)sciExponent + 1;
+            memcpy(buf + len, digits, intDigits);
+            len += intDigits;
+            buf[len++] = '.';
+            memcpy(buf + len, digits + intDigits, (size_t)digitCount - intDigits);
+            len += (size_t)digitCount - intDigits;
+        } else {
+            size_t zeros = (size_t)(-sciExponent - 1);
+            buf[len++] = '0';
+            buf[len++] = '.';
+            memset(buf + len, '0', zeros);
+            len += zeros;
+            memcpy(buf + len, digits, (size_t)digitCount);
+            len += (size_t)digitCount;
+        }
+    } else {
+        buf[len++] = digits[0];
+        if (digitCount > 1) {
+            buf[len++] = '.';
+            memcpy(buf + len, digits + 1, (size_t)digitCount - 1);
+            len += (size_t)digitCount - 1;
+        }
+        buf[len++] = 'e';
+        buf[len++] = sciExponent < 0 ? '-' : '+';
+        uint32_t absExponent = (uint32_t)(sciExponent < 0 ? -sciExponent : sciExponent);
+        if (absExponent >= 100) {
+            buf[len++] = (char)('0' + absExponent / 100);
+            absExponent %= 100;
+        }
+        memcpy(buf + len, g_digitPairs + absExponent * 2, 2);
+        len += 2;
+    }
+    return FinishFormat(buf, len, dest, destSize, outWritten);
+}
+
+/* Targets of the header's format dispatch macros */
+int SafeSnprintfInt(char *str, size_t size, long long value) {
+    size_t written;
+    if (!str) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeSnprintf");
+        return -1;
+    }
+    return SafeFmtInt(str, size, value, &written) ? (int)written : -1;
+}
+
+int SafeSnprintfUInt(char *str, size_t size, unsigned long long value) {
+    size_t written;
+    if (!str) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeSnprintf");
+        return -1;
+    }
+    return SafeFmtUInt(str, size, value, &written) ? (int)written : -1;
+}
+
+int SafeSnprintfHex(char *str, size_t size, unsigned long long value) {
+    size_t written;
+    if (!str) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeSnprintf");
+        return -1;
+    }
+    return SafeFmtHex(str, size, value, &written) ? (int)written : -1;
+}
+
+int SafeSnprintfStr(char *str, size_t size, const char *value) {
+    if (!str) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeSnprintf");
+        return -1;
+    }
+    if (!value) value = "(null)";  /* As SafeSnprintf prints it */
+    size_t len = strlen(value);
+    if (len > INT_MAX) {
+        str[0] = '\0';
+        SetError(SAFEOPS_ERR_OVERFLOW, "Formatted output too long");
+        return -1;
+    }
+    return FinishFormat(value, len, str, size, &len) ? (int)len : -1;
+}
+
+int SafePrintfStr(const char *text) {
+    if (!text) text = "(null)";
+
+    size_t len = strlen(text);
+    if (len > INT_MAX) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Formatted output too long");
+        return -1;
+    }
+    if (PrintIsBuffered()) {
+        return BufferedWrite(text, len);
+    }
+    if (fwrite(text, 1, len, stdout) != len) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to write to stdout");
+        return -1;
+    }
+    return (int)len;
+}
+
+/* ------------------------------------------------------
+   6b) Compiled Formats
+   ------------------------------------------------------ */
+
+struct SafeFormat {
+    FormatOp *ops;
+    size_t opCount;
+    const char *pool;  /* Literal runs with "%%" unescaped, and conversion specs */
+};
+
+/* Splits format into literal runs and conversions. With ops NULL it only
+   validates and sizes; every pool entry is NUL-terminated. */
+static bool BuildFormatOps(const char *format, FormatOp *ops, char *pool,
+                           size_t *outCount, size_t *outPoolLen) {
+    size_t count = 0;
+    size_t poolLen = 0;
+    bool inLiteral = false;
+
+    for (const char *p = format; *p; ) {
+        if (*p != '%' || p[1] == '%') {
+            if (!inLiteral) {
+                if (ops) {
+                    FormatOp literal = { FMT_ARG_NONE, 0, 0, true, poolLen, 0 };
+                    ops[count] = literal;
+                }
+                count++;
+                inLiteral = true;
+            }
+            if (ops) {
+                pool[poolLen] = *p;
+                ops[count - 1].textLen++;
+            }
+            poolLen++;
+            p += (*p == '%') ? 2 : 1;
+            continue;
+        }
+
+        if (inLiteral) {
+            if (pool) pool[poolLen] = '\0';
+            poolLen++;
+            inLiteral = false;
+        }
+        FormatOp op;
+        size_t specLen = ParseConversion(p, &op);
+        if (specLen == 0) {
+            SetError(SAFEOPS_ERR_INVALID_PARAM, "Unsupported or unsafe printf conversion");
+            return false;
+        }
+        if (ops) {
+            op.textOffset = poolLen;
+            op.textLen = specLen;
+            memcpy(pool + poolLen, p, specLen);
+            pool[poolLen + specLen] = '\0';
+            ops[count] = op;
+        }
+        poolLen += specLen + 1;
+        count++;
+        p += specLen;
+    }
+    if (inLiteral) {
+        if (pool) pool[poolLen] = '\0';
+        poolLen++;
+    }
+
+    *outCount = count;
+    *outPoolLen = poolLen;
+    return true;
+}
+
+SafeFormat* SafeFormatCompile(const char *format) {
+    if (!format) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFormatCompile");
+        return NULL;
+    }
+
+    size_t opCount, poolLen;
+    if (!BuildFormatOps(format, NULL, NULL, &opCount, &poolLen)) {
+        return NULL;
+    }
+    if (opCount > (SIZE_MAX - sizeof(SafeFormat) - poolLen) / sizeof(FormatOp)) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Format string too long");
+        return NULL;
+    }
+
+    /* One block: header, op array, then the text pool */
+    SafeFormat *compiled = (SafeFormat *)SafeMallocUninitialized(
+            sizeof(SafeFormat) + opCount * sizeof(FormatOp) + poolLen);
+    if (!compiled) {
+        return NULL;
+    }
+    FormatOp *ops = (FormatOp *)(compiled + 1);
+    char *pool = (char *)(ops + opCount);
+    BuildFormatOps(format, ops, pool, &opCount, &poolLen);
+
+    compiled->ops = ops;
+    compiled->opCount = opCount;
+    compiled->pool = pool;
+    return compiled;
+}
+
+void SafeFormatFree(SafeFormat **formatRef) {
+    if (!formatRef || !*formatRef) {
+        return;
+    }
+    SafeFree((void**)formatRef);
+}
+
+/* Output cursor: len keeps counting past size so the caller learns what was needed */
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} FormatSink;
+
+static void SinkAppend(FormatSink *sink, const char *data, size_t n) {
+    if (sink->len < sink->size && n <= sink->size - sink->len) {
+        memcpy(sink->buf + sink->len, data, n);
+    }
+    sink->len += n;
+}
+
+/* Delegates one non-simple conversion to snprintf with its own spec */
+#define FORMAT_WITH_STARS(value) \
+    (op->stars == 0 ? snprintf(dst, room, spec, value) : \
+     op->stars == 1 ? snprintf(dst, room, spec, stars[0], value) : \
+                      snprintf(dst, room, spec, stars[0], stars[1], value))
+
+static bool RunFormatOp(const FormatOp *op, const char *pool, FormatSink *sink, va_list *ap) {
+    const char *spec = pool + op->textOffset;
+    if (op->arg == FMT_ARG_NONE) {
+        SinkAppend(sink, spec, op->textLen);
+        return true;
+    }
+
+    int stars[2] = { 0, 0 };
+    for (unsigned k = 0; k < op->stars; k++) {
+        stars[k] = va_arg(*ap, int);
+    }
+    size_t room = (sink->len < sink->size) ? sink->size - sink->len : 0;
+    char *dst = room ? sink->buf + sink->len : NULL;
+    int n;
+
+    if (op->arg == FMT_ARG_STRING) {
+        const char *s = va_arg(*ap, const char *);
+        if (op->simple) {
+            if (!s) s = "(null)";
+            SinkAppend(sink, s, strlen(s));
+            return true;
+        }
+        n = FORMAT_WITH_STARS(s);
+    } else if (op->conversion == 'c' && op->arg == FMT_ARG_INT) {
+        int c = va_arg(*ap, int);
+        if (op->simple) {
+            char ch = (char)c;
+            SinkAppend(sink, &ch, 1);
+            return true;
+        }
+        n = FORMAT_WITH_STARS(c);
+    } else if (op->arg >= FMT_ARG_INT && op->arg <= FMT_ARG_PTRDIFF) {
+        bool isSigned = (op->conversion == 'd' || op->conversion == 'i');
+        uint64_t bits;
+        switch (op->arg) {
+            case FMT_ARG_INT:
+                bits = isSigned ? (uint64_t)(int64_t)va_arg(*ap, int) : va_arg(*ap, unsigned int);
+                break;
+            case FMT_ARG_LONG:
+                bits = isSigned ? (uint64_t)(int64_t)va_arg(*ap, long) : va_arg(*ap, unsigned long);
+                break;
+            case FMT_ARG_LLONG:
+                bits = isSigned ? (uint64_t)va_arg(*ap, long long) : va_arg(*ap, unsigned long long);
+                break;
+            case FMT_ARG_SIZE:  /* ptrdiff_t stands in for the signed size_t */
+                bits = isSigned ? (uint64_t)(int64_t)va_arg(*ap, ptrdiff_t) : va_arg(*ap, size_t);
+                break;
+            case FMT_ARG_INTMAX:
+                bits = isSigned ? (uint64_t)va_arg(*ap, intmax_t) : va_arg(*ap, uintmax_t);
+                break;
+            default:
+                bits = isSigned ? (uint64_t)(int64_t)va_arg(*ap, ptrdiff_t)
+                                : (uint64_t)(size_t)va_arg(*ap, ptrdiff_t);
+                break;
+        }
+
+        if (op->simple) {
+            char digits[24];
+            char *end = digits + sizeof(digits);
+            char *start;
+            if (op->conversion == 'x') {
+                start = WriteHexBackward(end, bits);
+            } else if (isSigned && (int64_t)bits < 0) {
+                start = WriteDigitsBackward(end, (uint64_t)0 - bits);
+                *--start = '-';
+            } else {
+                start = WriteDigitsBackward(end, bits);
+            }
+            SinkAppend(sink, start, (size_t)(end - start));
+            return true;
+        }
+
+        /* Hand the value back to snprintf in its original type */
+        switch (op->arg) {
+            case FMT_ARG_INT:
+                n = isSigned ? FORMAT_WITH_STARS((int)(int64_t)bits) : FORMAT_WITH_STARS((unsigned int)bits);
+                break;
+            case FMT_ARG_LONG:
+                n = isSigned ? FORMAT_WITH_STARS((long)(int64_t)bits) : FORMAT_WITH_STARS((unsigned long)bits);
+                break;
+            case FMT_ARG_LLONG:
+                n = isSigned ? FORMAT_WITH_STARS((long long)bits) : FORMAT_WITH_STARS((unsigned long long)bits);
+                break;
+            case FMT_ARG_SIZE:
+                n = FORMAT_WITH_STARS((size_t)bits);
+                break;
+            case FMT_ARG_INTMAX:
+                n = isSigned ? FORMAT_WITH_STARS((intmax_t)bits) : FORMAT_WITH_STARS((uintmax_t)bits);
+                break;
+            default:
+                n = FORMAT_WITH_STARS((ptrdiff_t)bits);
+                break;
+        }
+    } else {
+        switch (op->arg) {
+            case FMT_ARG_DOUBLE: {
+                double v = va_arg(*ap, double);
+                n = FORMAT_WITH_STARS(v);
+                break;
+            }
+            case FMT_ARG_LONG_DOUBLE: {
+                long double v = va_arg(*ap, long double);
+                n = FORMAT_WITH_STARS(v);
+                break;
+            }
+            case FMT_ARG_WSTRING: {
+                const wchar_t *v = va_arg(*ap, const wchar_t *);
+                n = FORMAT_WITH_STARS(v);
+                break;
+            }
+            case FMT_ARG_WINT: {
+                wint_t v = va_arg(*ap, wint_t);
+                n = FORMAT_WITH_STARS(v);
+                break;
+            }
+            default: {
+                void *v = va_arg(*ap, void *);
+                n = FORMAT_WITH_STARS(v);
+                break;
+            }
+        }
+    }
+
+    if (n < 0) {
+        return false;
+    }
+    sink->len += (size_t)n;
+    return true;
+}
+
+#undef FORMAT_WITH_STARS
+
+int SafeFormatRunV(const SafeFormat *format, char *buf, size_t size, va_list args) {
+    if (!format || !buf) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFormatRun");
+        return -1;
+    }
+    if (size == 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Destination size is 0");
+        return -1;
+    }
+
+    FormatSink sink = { buf, size, 0 };
+    va_list ap;
+    va_copy(ap, args);
+    bool ok = true;
+    for (size_t i = 0; i < format->opCount && ok; i++) {
+        ok = RunFormatOp(&format->ops[i], format->pool, &sink, &ap);
+    }
+    va_end(ap);
+
+    if (ok && sink.len < size) {
+        buf[sink.len] = '\0';
+    }
+    return FinishPrint(buf, size, (!ok || sink.len > INT_MAX) ? -1 : (int)sink.len);
+}
+
+int SafeFormatRun(const SafeFormat *format, char *buf, size_t size, ...) {
+    va_list args;
+    va_start(args, size);
+    int ret = SafeFormatRunV(format, buf, size, args);
+    va_end(args);
+    return ret;
+}
+
+/* ------------------------------------------------------
+   6c) Buffered Printf
+   ------------------------------------------------------ */
+
+/* Defined with the file helpers in section 7 */
+static bool WriteAll(int fd, const void *data, size_t size);
+static bool WritePair(int fd, const void *head, size_t headSize, const void *tail, size_t tailSize);
+
+#ifndef _WIN32
+
+#define SAFE_PRINT_DEFAULT_BUFFER (64 * 1024)
+#define SAFE_PRINT_DEFAULT_INTERVAL_MS 100
+
+typedef struct PrintBuffer {
+    pthread_mutex_t lock;      /* Owner while printing, SafePrintfFlushAll while draining */
+    char *data;
+    size_t len;
+    size_t capacity;
+    size_t lineEnd;            /* Bytes up to and including the last '\n' */
+    uint64_t pendingSince;     /* When the oldest complete line arrived, 0 if none */
+    struct PrintBuffer *prev;
+    struct PrintBuffer *next;
+} PrintBuffer;
+
+static pthread_once_t g_printOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t g_printKey;
+static bool g_printKeyReady = false;
+static pthread_mutex_t g_printRegistryLock = PTHREAD_MUTEX_INITIALIZER;
+/* Pipes split writes above PIPE_BUF, so batches from different threads
+   are serialised here rather than relying on write(2) atomicity */
+static pthread_mutex_t g_printWriteLock = PTHREAD_MUTEX_INITIALIZER;
+static PrintBuffer *g_printBuffers = NULL;  /* Every live thread buffer */
+static int g_printBuffered = 0;
+static size_t g_printBufferSize = SAFE_PRINT_DEFAULT_BUFFER;
+static uint64_t g_printIntervalNs = SAFE_PRINT_DEFAULT_INTERVAL_MS * 1000000ULL;
+static THREAD_LOCAL PrintBuffer *t_printBuffer = NULL;
+/* Background flusher: enforces the deadline for threads that go quiet */
+static pthread_mutex_t g_printFlusherLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_printFlusherCond = PTHREAD_COND_INITIALIZER;
+static bool g_printFlusherRunning = false;
+
+/* Millisecond resolution is plenty for flush deadlines; the coarse clock
+   is a plain memory read on Linux */
+static uint64_t MonotonicNs(void) {
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static bool PrintIsBuffered(void) {
+    return __atomic_load_n(&g_printBuffered, __ATOMIC_ACQUIRE) != 0;
+}
+
+/* Writes out complete lines, or everything when whole is set. Caller holds pb->lock. */
+static bool PrintBufferDrain(PrintBuffer *pb, bool whole) {
+    size_t end = whole ? pb->len : pb->lineEnd;
+    if (end == 0) {
+        return true;
+    }
+
+    pthread_mutex_lock(&g_printWriteLock);
+    bool ok = WriteAll(STDOUT_FILENO, pb->data, end);
+    pthread_mutex_unlock(&g_printWriteLock);
+    memmove(pb->data, pb->data + end, pb->len - end);
+    pb->len -= end;
+    pb->lineEnd = 0;
+    pb->pendingSince = 0;
+    if (!ok) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to write to stdout");
+    }
+    return ok;
+}
+
+/* Accounts for len bytes just placed at data + pb->len */
+static bool PrintBufferCommit(PrintBuffer *pb, size_t len) {
+    const char *text = pb->data + pb->len;
+    for (size_t i = len; i > 0; i--) {
+        if (text[i - 1] == '\n') {
+            pb->lineEnd = pb->len + i;
+            break;
+        }
+    }
+    pb->len += len;
+
+    if (pb->lineEnd == 0) {
+        return true;
+    }
+    uint64_t now = MonotonicNs();
+    if (pb->pendingSince == 0) {
+        pb->pendingSince = now;
+        return true;
+    }
+    if (now - pb->pendingSince >= __atomic_load_n(&g_printIntervalNs, __ATOMIC_RELAXED)) {
+        return PrintBufferDrain(pb, false);
+    }
+    return true;
+}
+
+static bool PrintBufferAppend(PrintBuffer *pb, const char *text, size_t len) {
+    bool ok = true;
+    if (len > pb->capacity - pb->len) {
+        ok = PrintBufferDrain(pb, false);
+    }
+    if (len <= pb->capacity - pb->len) {
+        memcpy(pb->data + pb->len, text, len);
+        return PrintBufferCommit(pb, len) && ok;
+    }
+
+    /* Bigger than the buffer: one writev together with the partial line before it */
+    pthread_mutex_lock(&g_printWriteLock);
+    ok = WritePair(STDOUT_FILENO, pb->data, pb->len, text, len) && ok;
+    pthread_mutex_unlock(&g_printWriteLock);
+    pb->len = 0;
+    pb->lineEnd = 0;
+    pb->pendingSince = 0;
+    if (!ok) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to write to stdout");
+    }
+    return ok;
+}
+
+/* pthread key destructor: the thread is exiting, so flush and unregister */
+static void PrintBufferRelease(void *value) {
+    PrintBuffer *pb = (PrintBuffer *)value;
+
+    pthread_mutex_lock(&g_printRegistryLock);
+    if (pb->prev) pb->prev->next = pb->next;
+    else g_printBuffers = pb->next;
+    if (pb->next) pb->next->prev = pb->prev;
+    pthread_mutex_unlock(&g_printRegistryLock);
+
+    pthread_mutex_lock(&pb->lock);
+    PrintBufferDrain(pb, true);
+    pthread_mutex_unlock(&pb->lock);
+
+    pthread_mutex_destroy(&pb->lock);
+    SafeFree((void**)&pb->data);
+    SafeFree((void**)&pb);
+    t_printBuffer = NULL;
+}
+
+/* Drains complete lines that have waited a full interval in any thread's
+   buffer. Returns how long until the next buffered line falls due, or the
+   whole interval if none is waiting. */
+static uint64_t PrintFlushDue(void) {
+    uint64_t interval = __atomic_load_n(&g_printIntervalNs, __ATOMIC_RELAXED);
+    uint64_t wait = interval;
+    uint64_t now = MonotonicNs();
+
+    pthread_mutex_lock(&g_printRegistryLock);
+    for (PrintBuffer *pb = g_printBuffers; pb; pb = pb->next) {
+        /* A thread holding its lock is printing and checks the deadline itself */
+        if (pthread_mutex_trylock(&pb->lock) != 0) {
+            continue;
+        }
+        if (pb->pendingSince != 0) {
+            uint64_t age = now - pb->pendingSince;
+            if (age >= interval) {
+                PrintBufferDrain(pb, false);
+            } else if (interval - age < wait) {
+                wait = interval - age;
+            }
+        }
+        pthread_mutex_unlock(&pb->lock);
+    }
+    pthread_mutex_unlock(&g_printRegistryLock);
+    return wait;
+}
+
+static void *PrintFlusherMain(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&g_printFlusherLock);
+    while (PrintIsBuffered()) {
+        pthread_mutex_unlock(&g_printFlusherLock);
+        uint64_t wait = PrintFlushDue();
+        pthread_mutex_lock(&g_printFlusherLock);
+
+        /* The coarse clock can lag a little; never spin on a zero wait */
+        if (wait < 1000000ULL) wait = 1000000ULL;
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        uint64_t ns = (uint64_t)deadline.tv_nsec + wait;
+        deadline.tv_sec += (time_t)(ns / 1000000000ULL);
+        deadline.tv_nsec = (long)(ns % 1000000000ULL);
+        if (PrintIsBuffered()) {
+            pthread_cond_timedwait(&g_printFlusherCond, &g_printFlusherLock, &deadline);
+        }
+    }
+    g_printFlusherRunning = false;
+    pthread_mutex_unlock(&g_printFlusherLock);
+    return NULL;
+}
+
+/* Starts the flusher, or wakes it to pick up a new interval or to exit */
+static bool PrintFlusherKick(void) {
+    bool ok = true;
+    pthread_mutex_lock(&g_printFlusherLock);
+    if (!g_printFlusherRunning && PrintIsBuffered()) {
+        pthread_t thread;
+        ok = pthread_create(&thread, NULL, PrintFlusherMain, NULL) == 0;
+        if (ok) {
+            pthread_detach(thread);
+            g_printFlusherRunning = true;
+        }
+    }
+    pthread_cond_signal(&g_printFlusherCond);
+    pthread_mutex_unlock(&g_printFlusherLock);
+    return ok;
+}
+
+static void PrintFlushAtExit(void) {
+    SafePrintfFlushAll();
+}
+
+static void PrintInitOnce(void) {
+    g_printKeyReady = (pthread_key_create(&g_printKey, PrintBufferRelease) == 0);
+    /* Threads still running at exit, and the main thread, never run key destructors */
+    atexit(PrintFlushAtExit);
+}
+
+static PrintBuffer *PrintBufferForThread(void) {
+    if (t_printBuffer) {
+        return t_printBuffer;
+    }
+
+    PrintBuffer *pb = (PrintBuffer *)SafeMalloc(sizeof(PrintBuffer));
+    if (!pb) {
+        return NULL;
+    }
+    pb->capacity = __atomic_load_n(&g_printBufferSize, __ATOMIC_RELAXED);
+    pb->data = (char *)SafeMallocUninitialized(pb->capacity);
+    if (!pb->data) {
+        SafeFree((void**)&pb);
+        return NULL;
+    }
+    pthread_mutex_init(&pb->lock, NULL);
+    if (pthread_setspecific(g_printKey, pb) != 0) {
+        pthread_mutex_destroy(&pb->lock);
+        SafeFree((void**)&pb->data);
+        SafeFree((void**)&pb);
+        SetError(SAFEOPS_ERR_ALLOCATION_FAILED, "Failed to register print buffer");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_printRegistryLock);
+    pb->next = g_printBuffers;
+    if (g_printBuffers) g_printBuffers->prev = pb;
+    g_printBuffers = pb;
+    pthread_mutex_unlock(&g_printRegistryLock);
+
+    t_printBuffer = pb;
+    return pb;
+}
+
+static int BufferedVPrintf(const char *format, va_list args) {
+    PrintBuffer *pb = PrintBufferForThread();
+    if (!pb) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&pb->lock);
+    size_t room = pb->capacity - pb->len;
+    va_list copy;
+    va_copy(copy, args);
+    int n = vsnprintf(pb->data + pb->len, room, format, copy);
+    va_end(copy);
+
+    bool ok;
+    if (n < 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Formatting failed");
+        ok = false;
+    } else if ((size_t)n < room) {
+        ok = PrintBufferCommit(pb, (size_t)n);
+    } else {
+        /* Did not fit the free space: format again off to the side */
+        char *text = (char *)SafeMallocUninitialized((size_t)n + 1);
+        ok = text != NULL;
+        if (ok) {
+            vsnprintf(text, (size_t)n + 1, format, args);
+            ok = PrintBufferAppend(pb, text, (size_t)n);
+            SafeFree((void**)&text);
+        }
+    }
+    pthread_mutex_unlock(&pb->lock);
+
+    return ok ? n : -1;
+}
+
+static int BufferedWrite(const char *text, size_t len) {
+    PrintBuffer *pb = PrintBufferForThread();
+    if (!pb) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&pb->lock);
+    bool ok = PrintBufferAppend(pb, text, len);
+    pthread_mutex_unlock(&pb->lock);
+
+    return ok ? (int)len : -1;
+}
+
+bool SafePrintfSetBuffered(bool enabled, size_t bufferSize, unsigned int flushIntervalMs) {
+    pthread_once(&g_printOnce, PrintInitOnce);
+    if (!g_printKeyReady) {
+        SetError(SAFEOPS_ERR_ALLOCATION_FAILED, "Failed to create print buffer key");
+        return false;
+    }
+
+    if (!enabled) {
+        __atomic_store_n(&g_printBuffered, 0, __ATOMIC_RELEASE);
+        PrintFlusherKick();
+        return SafePrintfFlushAll();
+    }
+
+    if (bufferSize == 0) bufferSize = SAFE_PRINT_DEFAULT_BUFFER;
+    if (flushIntervalMs == 0) flushIntervalMs = SAFE_PRINT_DEFAULT_INTERVAL_MS;
+    __atomic_store_n(&g_printBufferSize, bufferSize, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_printIntervalNs, (uint64_t)flushIntervalMs * 1000000ULL, __ATOMIC_RELAXED);
+
+    /* Output already queued in stdio must not end up behind buffered lines */
+    fflush(stdout);
+    __atomic_store_n(&g_printBuffered, 1, __ATOMIC_RELEASE);
+    if (!PrintFlusherKick()) {
+        __atomic_store_n(&g_printBuffered, 0, __ATOMIC_RELEASE);
+        SetError(SAFEOPS_ERR_ALLOCATION_FAILED, "Failed to start print flusher thread");
+        return false;
+    }
+    return true;
+}
+
+bool SafePrintfFlush(void) {
+    PrintBuffer *pb = t_printBuffer;
+    if (!pb) {
+        return true;
+    }
+
+    pthread_mutex_lock(&pb->lock);
+    bool ok = PrintBufferDrain(pb, true);
+    pthread_mutex_unlock(&pb->lock);
+    return ok;
+}
+
+bool SafePrintfFlushAll(void) {
+    bool ok = true;
+    pthread_mutex_lock(&g_printRegistryLock);
+    for (PrintBuffer *pb = g_printBuffers; pb; pb = pb->next) {
+        pthread_mutex_lock(&pb->lock);
+        ok = PrintBufferDrain(pb, true) && ok;
+        pthread_mutex_unlock(&pb->lock);
+    }
+    pthread_mutex_unlock(&g_printRegistryLock);
+    return ok;
+}
+
+#else
+
+static bool PrintIsBuffered(void) {
+    return false;
+}
+
+static int BufferedVPrintf(const char *format, va_list args) {
+    return vprintf(format, args);
+}
+
+static int BufferedWrite(const char *text, size_t len) {
+    return WriteAll(1, text, len) ? (int)len : -1;
+}
+
+bool SafePrintfSetBuffered(bool enabled, size_t bufferSize, unsigned int flushIntervalMs) {
+    (void)bufferSize; (void)flushIntervalMs;
+    if (enabled) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Buffered printf is not supported on this platform");
+        return false;
+    }
+    return true;
+}
+
+bool SafePrintfFlush(void) {
+    return true;
+}
+
+bool SafePrintfFlushAll(void) {
+    return true;
+}
+
+#endif
+
+/* ------------------------------------------------------
+   7) TOCTOU & File Handling
+   ------------------------------------------------------ */
+
+/* Default policy used when callers pass NULL options */
+static const SafeFileOpts g_defaultFileOpts = {
+        .followSymlinks = false,
+        .requireRegularFile = true,
+        .createMode = 0644,
+        .secureDelete = false
+};
+
+#ifndef _WIN32
+/* Translate an fopen-style mode string into open(2) flags */
+static int ModeToOpenFlags(const char *mode) {
+    int flags = O_RDONLY;
+    if (strchr(mode, 'w')) flags = O_WRONLY | O_CREAT | O_TRUNC;
+    else if (strchr(mode, 'a')) flags = O_WRONLY | O_CREAT | O_APPEND;
+    return flags;
+}
+
+/* Opens filePath under the SafeFOpen policy: no symlink following unless
+   allowed, fstat on the descriptor itself and the optional regular-file
+   check. Returns the descriptor, or -1 with the library error set. */
+static int OpenCheckedFd(const char *filePath, int flags, const SafeFileOpts *opts, struct stat *outSt) {
+    if (!opts->followSymlinks) {
+        #ifdef O_NOFOLLOW
+            flags |= O_NOFOLLOW;
+        #endif
+    }
+
+    int fd = open(filePath, flags, opts->createMode);
+    if (fd == -1) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to open file");
+        return -1;
+    }
+
+    /* Get file information using the file descriptor to avoid TOCTOU */
+    if (fstat(fd, outSt) != 0) {
+        close(fd);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to stat file");
+        return -1;
+    }
+
+    if (opts->requireRegularFile && !S_ISREG(outSt->st_mode)) {
+        close(fd);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Not a regular file");
+        return -1;
+    }
+
+    return fd;
+}
+
+/* Reserves disk blocks for [offset, offset + size) without changing the
+   visible file size (posix_fallocate would extend the file and leave
+   trailing zeros). Advisory: failures are ignored. */
+static void PreallocateFd(int fd, long long offset, unsigned long long size) {
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    if (size <= (unsigned long long)(LLONG_MAX - offset)) {
+        (void)fallocate(fd, FALLOC_FL_KEEP_SIZE, (off_t)offset, (off_t)size);
+    }
+#else
+    (void)fd;
+    (void)offset;
+    (void)size;
+#endif
+}
+#endif
+
+FILE* SafeFOpen(const char *filePath, const char *mode, const SafeFileOpts *opts) {
+    if (!filePath || !mode) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFOpen");
+        return NULL;
+    }
+
+    /* Use default options if none provided */
+    if (!opts) opts = &g_defaultFileOpts;
+
+    FILE *fp = NULL;
+    struct stat st;
+
+#ifdef _WIN32
+    /* Windows implementation */
+    if (fopen_s(&fp, filePath, mode) != 0) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to open file");
+        return NULL;
+    }
+
+    int fd = _fileno(fp);
+    if (_fstat(fd, &st) != 0) {
+        fclose(fp);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to stat file");
+        return NULL;
+    }
 
     /* Verify file type if required */
     if (opts->requireRegularFile && !S_ISREG(st.st_mode)) {
+        fclose(fp);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Not a regular file");
+        return NULL;
+    }
+#else
+    /* POSIX implementation with enhanced security */
+    int fd = OpenCheckedFd(filePath, ModeToOpenFlags(mode), opts, &st);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    fp = fdopen(fd, mode);
+    if (!fp) {
+        close(fd);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to create FILE stream");
+        return NULL;
+    }
+#endif
+
+    return fp;
+}
+
+#ifndef _WIN32
+/* Walks relPath one component at a time with openat, never following a
+   symlink and never accepting "..". Used where openat2 is unavailable. */
+static int OpenBeneathWalk(int dirFd, const char *relPath, int flags, unsigned int mode) {
+#ifdef O_PATH
+    const int dirFlags = O_PATH | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+#else
+    const int dirFlags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+#endif
+    int cur = dirFd;
+    const char *p = relPath;
+
+    for (;;) {
+        while (*p == '/') p++;
+        const char *end = strchr(p, '/');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+
+        /* Trailing slashes: the previous component was the last one */
+        const char *rest = end;
+        while (rest && *rest == '/') rest++;
+        bool last = !end || *rest == '\0';
+
+        char name[NAME_MAX + 1];
+        if (len == 0 || len > NAME_MAX) {
+            if (cur != dirFd) close(cur);
+            errno = ENOENT;
+            return -1;
+        }
+        memcpy(name, p, len);
+        name[len] = '\0';
+
+        if (strcmp(name, "..") == 0) {
+            if (cur != dirFd) close(cur);
+            errno = EXDEV;
+            return -1;
+        }
+
+        int next;
+        if (last) {
+            next = openat(cur, name, flags | O_NOFOLLOW, mode);
+        } else if (strcmp(name, ".") == 0) {
+            p = rest;
+            continue;
+        } else {
+            next = openat(cur, name, dirFlags);
+        }
+
+        int savedErrno = errno;
+        if (cur != dirFd) close(cur);
+        errno = savedErrno;
+        if (next == -1 || last) {
+            return next;
+        }
+        cur = next;
+        p = rest;
+    }
+}
+
+#define OPENAT2_RETRIES 8
+
+/* Opens relPath strictly beneath dirFd: absolute paths, escaping ".." and
+   (unless allowed) symlinks anywhere in the path are refused. */
+static int OpenBeneathFd(int dirFd, const char *relPath, int flags, const SafeFileOpts *opts,
+                         struct stat *outSt) {
+    if (relPath[0] == '\0' || relPath[0] == '/') {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Path must be relative to the directory");
+        return -1;
+    }
+
+    flags |= O_CLOEXEC;
+    int fd = -1;
+    bool resolved = false;
+
+#ifdef SAFEOPS_HAVE_OPENAT2
+    /* One syscall resolves and checks every component in the kernel */
+    struct open_how how;
+    memset(&how, 0, sizeof(how));
+    how.flags = (unsigned long long)flags;
+    how.mode = (flags & O_CREAT) ? opts->createMode : 0;
+    how.resolve = RESOLVE_BENEATH | RESOLVE_NO_MAGICLINKS;
+    if (!opts->followSymlinks) {
+        how.resolve |= RESOLVE_NO_SYMLINKS;
+    }
+
+    /* EAGAIN: a concurrent rename raced a ".." lookup; the kernel asks for a retry */
+    for (int attempt = 0; attempt < OPENAT2_RETRIES; attempt++) {
+        fd = (int)syscall(__NR_openat2, dirFd, relPath, &how, sizeof(how));
+        if (fd != -1 || errno != EAGAIN) break;
+    }
+    /* Old kernels lack openat2 and seccomp profiles may reject it outright */
+    resolved = (fd != -1 || (errno != ENOSYS && errno != EPERM && errno != EOPNOTSUPP));
+#endif
+
+    if (!resolved) {
+        fd = OpenBeneathWalk(dirFd, relPath, flags, opts->createMode);
+    }
+
+    if (fd == -1) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to open file beneath directory");
+        return -1;
+    }
+
+    if (fstat(fd, outSt) != 0) {
+        close(fd);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to stat file");
+        return -1;
+    }
+
+    if (opts->requireRegularFile && !S_ISREG(outSt->st_mode)) {
+        close(fd);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Not a regular file");
+        return -1;
+    }
+
+    return fd;
+}
+#endif
+
+FILE* SafeFOpenAt(int dirFd, const char *relPath, const char *mode, const SafeFileOpts *opts) {
+    if (!relPath || !mode) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFOpenAt");
+        return NULL;
+    }
+
+#ifdef _WIN32
+    (void)dirFd;
+    (void)opts;
+    SetError(SAFEOPS_ERR_FILE_ACCESS, "Directory-relative open is not supported on this platform");
+    return NULL;
+#else
+    if (!opts) opts = &g_defaultFileOpts;
+
+    struct stat st;
+    int fd = OpenBeneathFd(dirFd, relPath, ModeToOpenFlags(mode), opts, &st);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    FILE *fp = fdopen(fd, mode);
+    if (!fp) {
+        close(fd);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to create FILE stream");
+        return NULL;
+    }
+    return fp;
+#endif
+}
+
+/* Same checks as SafeFOpen, but hands back the raw descriptor (close-on-exec) */
+int SafeFOpenFd(const char *filePath, const char *mode, const SafeFileOpts *opts) {
+    if (!filePath || !mode) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFOpenFd");
+        return -1;
+    }
+
+    if (!opts) opts = &g_defaultFileOpts;
+
+#ifdef _WIN32
+    int oflags = _O_RDONLY | _O_BINARY;
+    if (strchr(mode, 'w')) oflags = _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY;
+    else if (strchr(mode, 'a')) oflags = _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY;
+
+    int fd = -1;
+    struct _stat64 st;
+    if (_sopen_s(&fd, filePath, oflags | _O_NOINHERIT, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to open file");
+        return -1;
+    }
+    if (_fstat64(fd, &st) != 0 || (opts->requireRegularFile && !S_ISREG(st.st_mode))) {
+        _close(fd);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Not a regular file");
+        return -1;
+    }
+    return fd;
+#else
+    struct stat st;
+    return OpenCheckedFd(filePath, ModeToOpenFlags(mode) | O_CLOEXEC, opts, &st);
+#endif
+}
+
+bool SafeFClose(FILE **fp) {
+    if (!fp || !*fp) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFClose");
+        return false;
+    }
+
+    /* fclose reports buffered-write failures; surface them instead of losing data silently */
+    int rc = fclose(*fp);
+    *fp = NULL;
+    if (rc != 0) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to flush or close file");
+        return false;
+    }
+    return true;
+}
+
+#define SAFE_WIPE_CHUNK (1024 * 1024)
+
+/* Overwrites [start, end) with zeros from an aligned, chunk-sized buffer */
+static bool WipeRange(int fd, const void *zeros, long long start, long long end) {
+    while (start < end) {
+        size_t chunk = (end - start > SAFE_WIPE_CHUNK) ? SAFE_WIPE_CHUNK : (size_t)(end - start);
+#ifdef _WIN32
+        if (_lseeki64(fd, start, SEEK_SET) < 0) return false;
+        int n = _write(fd, zeros, (unsigned int)chunk);
+#else
+        ssize_t n = pwrite(fd, zeros, chunk, (off_t)start);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        start += n;
+    }
+    return true;
+}
+
+static bool WipeFileContents(int fd, long long size) {
+    void *zeros = NULL;
+#ifdef _WIN32
+    zeros = _aligned_malloc(SAFE_WIPE_CHUNK, 4096);
+#else
+    if (posix_memalign(&zeros, 4096, SAFE_WIPE_CHUNK) != 0) zeros = NULL;
+#endif
+    if (!zeros) {
+        SetError(SAFEOPS_ERR_ALLOCATION_FAILED, "Failed to allocate wipe buffer");
+        return false;
+    }
+    memset(zeros, 0, SAFE_WIPE_CHUNK);
+
+    bool ok = true;
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    /* Holes hold no data: only overwrite the allocated extents of sparse files */
+    long long pos = 0;
+    while (ok && pos < size) {
+        off_t dataStart = lseek(fd, (off_t)pos, SEEK_DATA);
+        if (dataStart < 0) {
+            if (errno == ENXIO) break;  /* No data past pos */
+            ok = WipeRange(fd, zeros, pos, size);  /* Filesystem lacks extent queries */
+            break;
+        }
+        off_t dataEnd = lseek(fd, dataStart, SEEK_HOLE);
+        if (dataEnd < 0 || dataEnd > size) dataEnd = (off_t)size;
+        ok = WipeRange(fd, zeros, dataStart, dataEnd);
+        pos = dataEnd;
+    }
+#else
+    ok = WipeRange(fd, zeros, 0, size);
+#endif
+
+#ifdef _WIN32
+    _aligned_free(zeros);
+    ok = ok && _commit(fd) == 0;
+#else
+    free(zeros);
+    ok = ok && fdatasync(fd) == 0;
+#endif
+    if (!ok) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to overwrite file contents");
+    }
+    return ok;
+}
+
+#ifndef _WIN32
+/* Whether path still names the file described by st, resolved with the same
+   symlink rule the file was opened with */
+static bool SameFileAtPath(const char *path, bool followSymlinks, const struct stat *st) {
+    struct stat current;
+    int result = followSymlinks ? stat(path, &current) : lstat(path, &current);
+    if (result != 0 || current.st_dev != st->st_dev || current.st_ino != st->st_ino) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "File was replaced before it could be removed");
+        return false;
+    }
+    return true;
+}
+#endif
+
+bool SafeSecureUnlink(const char *filePath, const SafeFileOpts *opts) {
+    if (!filePath) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeSecureUnlink");
+        return false;
+    }
+
+    if (!opts) opts = &g_defaultFileOpts;
+
+#ifdef _WIN32
+    int fd = -1;
+    struct _stat64 st;
+    if (_sopen_s(&fd, filePath, _O_WRONLY | _O_BINARY, _SH_DENYRW, 0) != 0) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to open file");
+        return false;
+    }
+    if (_fstat64(fd, &st) != 0 || (opts->requireRegularFile && !S_ISREG(st.st_mode))) {
+        _close(fd);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Not a regular file");
+        return false;
+    }
+
+    bool ok = !opts->secureDelete || WipeFileContents(fd, (long long)st.st_size);
+    _close(fd);
+    if (ok && _unlink(filePath) != 0) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to remove file");
+        ok = false;
+    }
+    return ok;
+#else
+    /* A wipe never goes through a symlink: unlink would remove the link and
+       leave the wiped target behind under its own name. A plain unlink needs
+       no access to the file itself, only to its directory. */
+    SafeFileOpts checked = *opts;
+    int flags = O_CLOEXEC;
+    if (opts->secureDelete) {
+        checked.followSymlinks = false;
+        flags |= O_WRONLY;
+    } else {
+#ifdef O_PATH
+        flags |= O_PATH;
+#else
+        flags |= O_RDONLY;
+#endif
+    }
+
+    struct stat st;
+    int fd = OpenCheckedFd(filePath, flags, &checked, &st);
+    if (fd == -1) {
+        return false;
+    }
+
+    /* Only touch the file, and later remove the name, while the name still
+       refers to the file that was opened */
+    bool ok = SameFileAtPath(filePath, checked.followSymlinks, &st);
+    ok = ok && (!opts->secureDelete || WipeFileContents(fd, (long long)st.st_size));
+    ok = ok && SameFileAtPath(filePath, checked.followSymlinks, &st);
+    if (ok && unlink(filePath) != 0) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to remove file");
+        ok = false;
+    }
+
+    close(fd);
+    return ok;
+#endif
+}
+
+/* Size of the SafeFileOptsEx prefix every caller must provide */
+#define SAFE_FILE_OPTS_EX_MIN_SIZE (offsetof(SafeFileOptsEx, base) + sizeof(SafeFileOpts))
+
+/* Copies a caller's (possibly older, shorter) SafeFileOptsEx over the current
+   defaults, so fields added after the caller was compiled keep default values */
+static bool LoadFileOptsEx(const SafeFileOptsEx *opts, SafeFileOptsEx *out) {
+    const SafeFileOptsEx defaults = SAFE_FILE_OPTS_EX_INIT;
+    *out = defaults;
+    if (!opts) {
+        return true;
+    }
+
+    if (opts->structSize < SAFE_FILE_OPTS_EX_MIN_SIZE) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "SafeFileOptsEx.structSize not initialised");
+        return false;
+    }
+    memcpy(out, opts, (opts->structSize < sizeof(*out)) ? opts->structSize : sizeof(*out));
+    out->structSize = sizeof(*out);
+
+    if ((int)out->advice < SAFE_ADVICE_NORMAL || (int)out->advice > SAFE_ADVICE_DONTNEED) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Unknown access advice");
+        return false;
+    }
+    return true;
+}
+
+/* SafeFOpenFd plus the access-pattern options */
+static int OpenCheckedFdEx(const char *filePath, const char *mode, const SafeFileOptsEx *ex) {
+#ifdef _WIN32
+    if (ex->directIO || ex->noAtime || ex->advice != SAFE_ADVICE_NORMAL ||
+        ex->readaheadBytes || ex->preallocBytes) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Access options are not supported on this platform");
+        return -1;
+    }
+    return SafeFOpenFd(filePath, mode, &ex->base);
+#else
+    int flags = ModeToOpenFlags(mode) | O_CLOEXEC;
+    bool writing = (flags & O_ACCMODE) != O_RDONLY;
+
+    if (ex->readaheadBytes > 0 && writing) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Readahead requires a read mode");
+        return -1;
+    }
+    if (ex->preallocBytes > 0 && !writing) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Preallocation requires a write mode");
+        return -1;
+    }
+    if (ex->preallocBytes > (unsigned long long)LLONG_MAX ||
+        ex->readaheadBytes > (unsigned long long)LLONG_MAX) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Access option size out of range");
+        return -1;
+    }
+
+    if (ex->directIO) {
+#ifdef O_DIRECT
+        flags |= O_DIRECT;
+#elif !defined(F_NOCACHE)
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Direct I/O is not supported on this platform");
+        return -1;
+#endif
+    }
+
+    struct stat st;
+    int fd = -1;
+#ifdef O_NOATIME
+    if (ex->noAtime) {
+        /* Only permitted for the file's owner; otherwise fall back to a normal open */
+        fd = OpenCheckedFd(filePath, flags | O_NOATIME, &ex->base, &st);
+        if (fd == -1 && errno != EPERM) {
+            return -1;
+        }
+    }
+#endif
+    if (fd == -1) {
+        fd = OpenCheckedFd(filePath, flags, &ex->base, &st);
+        if (fd == -1) {
+            return -1;
+        }
+    }
+
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+    if (ex->directIO) {
+        (void)fcntl(fd, F_NOCACHE, 1);
+    }
+#endif
+
+#ifdef POSIX_FADV_NORMAL
+    static const int adviceMap[] = {
+        POSIX_FADV_NORMAL, POSIX_FADV_SEQUENTIAL, POSIX_FADV_RANDOM,
+        POSIX_FADV_NOREUSE, POSIX_FADV_WILLNEED, POSIX_FADV_DONTNEED
+    };
+    if (ex->advice != SAFE_ADVICE_NORMAL) {
+        (void)posix_fadvise(fd, 0, 0, adviceMap[ex->advice]);
+    }
+    if (ex->readaheadBytes > 0) {
+#ifdef __linux__
+        (void)readahead(fd, 0, (size_t)ex->readaheadBytes);
+#else
+        (void)posix_fadvise(fd, 0, (off_t)ex->readaheadBytes, POSIX_FADV_WILLNEED);
+#endif
+    }
+#endif
+
+    if (ex->preallocBytes > 0) {
+        PreallocateFd(fd, (long long)st.st_size, ex->preallocBytes);
+    }
+    return fd;
+#endif
+}
+
+FILE* SafeFOpenEx(const char *filePath, const char *mode, const SafeFileOptsEx *opts) {
+    if (!filePath || !mode) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFOpenEx");
+        return NULL;
+    }
+
+    SafeFileOptsEx ex;
+    if (!LoadFileOptsEx(opts, &ex)) {
+        return NULL;
+    }
+
+    /* stdio buffers do not meet O_DIRECT alignment rules; use SafeFOpenFdEx */
+    if (ex.directIO) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Direct I/O requires SafeFOpenFdEx");
+        return NULL;
+    }
+
+    int fd = OpenCheckedFdEx(filePath, mode, &ex);
+    if (fd == -1) {
+        return NULL;
+    }
+
+#ifdef _WIN32
+    FILE *fp = _fdopen(fd, mode);
+#else
+    FILE *fp = fdopen(fd, mode);
+#endif
+    if (!fp) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to create FILE stream");
+        return NULL;
+    }
+    return fp;
+}
+
+int SafeFOpenFdEx(const char *filePath, const char *mode, const SafeFileOptsEx *opts) {
+    if (!filePath || !mode) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFOpenFdEx");
+        return -1;
+    }
+
+    SafeFileOptsEx ex;
+    if (!LoadFileOptsEx(opts, &ex)) {
+        return -1;
+    }
+
+    return OpenCheckedFdEx(filePath, mode, &ex);
+}
+
+/* Read-only, zero-copy view of a whole file */
+bool SafeFMap(const char *filePath, const SafeFileOpts *opts, unsigned int hints, SafeFileView *outView) {
+    if (!filePath || !outView) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFMap");
+        return false;
+    }
+
+    if (!opts) opts = &g_defaultFileOpts;
+    outView->data = NULL;
+    outView->size = 0;
+
+#ifdef _WIN32
+    (void)hints;  /* No madvise equivalent worth applying */
+    int fd = -1;
+    struct _stat64 st;
+    if (_sopen_s(&fd, filePath, _O_RDONLY | _O_BINARY, _SH_DENYNO, 0) != 0) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to open file");
+        return false;
+    }
+    if (_fstat64(fd, &st) != 0 || (opts->requireRegularFile && !S_ISREG(st.st_mode))) {
+        _close(fd);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Not a regular file");
+        return false;
+    }
+#else
+    struct stat st;
+    int fd = OpenCheckedFd(filePath, O_RDONLY, opts, &st);
+    if (fd == -1) {
+        return false;
+    }
+#endif
+
+    if ((unsigned long long)st.st_size > SIZE_MAX) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+        SetError(SAFEOPS_ERR_OVERFLOW, "File too large to map");
+        return false;
+    }
+
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        /* Nothing to map; an empty view is still a valid result */
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+        return true;
+    }
+
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingA((HANDLE)_get_osfhandle(fd), NULL, PAGE_READONLY, 0, 0, NULL);
+    void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size) : NULL;
+    if (mapping) CloseHandle(mapping);
+    _close(fd);
+    if (!data) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to map file");
+        return false;
+    }
+#else
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    /* The mapping holds its own reference to the file */
+    close(fd);
+    if (data == MAP_FAILED) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to map file");
+        return false;
+    }
+
+    /* Hints are advisory; a kernel that rejects one still gives a usable view */
+    if (hints & SAFE_MAP_SEQUENTIAL) {
+        (void)madvise(data, size, MADV_SEQUENTIAL);
+    }
+    if (hints & SAFE_MAP_WILLNEED) {
+        (void)madvise(data, size, MADV_WILLNEED);
+    }
+#ifdef MADV_HUGEPAGE
+    if (hints & SAFE_MAP_HUGEPAGE) {
+        (void)madvise(data, size, MADV_HUGEPAGE);
+    }
+#endif
+#endif
+
+    outView->data = data;
+    outView->size = size;
+    return true;
+}
+
+bool SafeFUnmap(SafeFileView *view) {
+    if (!view) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFUnmap");
+        return false;
+    }
+
+    if (view->data) {
+#ifdef _WIN32
+        if (!UnmapViewOfFile(view->data)) {
+#else
+        if (munmap((void *)view->data, view->size) != 0) {
+#endif
+            SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to unmap file");
+            return false;
+        }
+    }
+
+    view->data = NULL;
+    view->size = 0;
+    return true;
+}
+
+/* ------------------------------------------------------
+   7a) Buffered Descriptor Writes
+   ------------------------------------------------------ */
+
+#define SAFE_WRITER_DEFAULT_BUFFER (1024 * 1024)
+
+/* Plain user-space buffer in front of a descriptor. Owned by one thread at a
+   time, so unlike stdio there is no per-call stream locking. */
+typedef struct {
+    int fd;
+    unsigned char *buffer;
+    size_t used;
+    size_t capacity;
+    bool failed;  /* Sticky: a failed write leaves the output incomplete */
+} SafeFdBuffer;
+
+/* write() until everything is out, retrying on EINTR and short writes */
+static bool WriteAll(int fd, const void *data, size_t size) {
+    const unsigned char *p = (const unsigned char *)data;
+    while (size > 0) {
+#ifdef _WIN32
+        unsigned int chunk = (size > INT_MAX) ? INT_MAX : (unsigned int)size;
+        int n = _write(fd, p, chunk);
+#else
+        ssize_t n = write(fd, p, size);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+/* Writes head then tail, in a single writev() when the kernel accepts it all */
+static bool WritePair(int fd, const void *head, size_t headSize, const void *tail, size_t tailSize) {
+#ifdef _WIN32
+    return WriteAll(fd, head, headSize) && WriteAll(fd, tail, tailSize);
+#else
+    struct iovec iov[2];
+    iov[0].iov_base = (void *)head;
+    iov[0].iov_len = headSize;
+    iov[1].iov_base = (void *)tail;
+    iov[1].iov_len = tailSize;
+
+    struct iovec *cur = iov;
+    int count = 2;
+    while (count > 0) {
+        ssize_t n = writev(fd, cur, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        /* Skip fully written vectors, trim a partially written one */
+        size_t done = (size_t)n;
+        while (count > 0 && done >= cur->iov_len) {
+            done -= cur->iov_len;
+            cur++;
+            count--;
+        }
+        if (count > 0) {
+            cur->iov_base = (char *)cur->iov_base + done;
+            cur->iov_len -= done;
+        }
+    }
+    return true;
+#endif
+}
+
+static bool FdBufferInit(SafeFdBuffer *out, int fd, size_t capacity) {
+    out->fd = fd;
+    out->used = 0;
+    out->capacity = capacity;
+    out->failed = false;
+    out->buffer = (unsigned char *)SafeMallocUninitialized(capacity);
+    return out->buffer != NULL;
+}
+
+static bool FdBufferFlush(SafeFdBuffer *out) {
+    if (out->used > 0) {
+        if (!WriteAll(out->fd, out->buffer, out->used)) {
+            out->failed = true;
+            SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to write file");
+            return false;
+        }
+        out->used = 0;
+    }
+    return true;
+}
+
+static bool FdBufferWrite(SafeFdBuffer *out, const void *data, size_t size) {
+    if (out->failed) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Writer is in a failed state");
+        return false;
+    }
+
+    if (size <= out->capacity - out->used) {
+        memcpy(out->buffer + out->used, data, size);
+        out->used += size;
+        return true;
+    }
+
+    /* Buffer is full: emit pending bytes and the new data together rather
+       than copying the new data in piecemeal */
+    if (!WritePair(out->fd, out->buffer, out->used, data, size)) {
+        out->failed = true;
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to write file");
+        return false;
+    }
+    out->used = 0;
+    return true;
+}
+
+static void FdBufferRelease(SafeFdBuffer *out) {
+    if (out->fd != -1) {
+#ifdef _WIN32
+        _close(out->fd);
+#else
+        close(out->fd);
+#endif
+        out->fd = -1;
+    }
+    SafeFree((void**)&out->buffer);
+}
+
+struct SafeFileWriter {
+    SafeFdBuffer out;
+};
+
+SafeFileWriter* SafeFileWriterOpen(const char *filePath, const char *mode, const SafeFileOpts *opts,
+                                   size_t bufferSize, size_t preallocSize) {
+    if (!filePath || !mode) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFileWriterOpen");
+        return NULL;
+    }
+
+    if (!strchr(mode, 'w') && !strchr(mode, 'a')) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "SafeFileWriter requires a write or append mode");
+        return NULL;
+    }
+
+    if (!opts) opts = &g_defaultFileOpts;
+    if (bufferSize == 0) bufferSize = SAFE_WRITER_DEFAULT_BUFFER;
+
+#ifdef _WIN32
+    int oflags = _O_WRONLY | _O_CREAT | _O_BINARY | (strchr(mode, 'w') ? _O_TRUNC : _O_APPEND);
+    int fd = -1;
+    struct _stat64 st;
+    if (_sopen_s(&fd, filePath, oflags, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to open file");
+        return NULL;
+    }
+    if (_fstat64(fd, &st) != 0 || (opts->requireRegularFile && !S_ISREG(st.st_mode))) {
+        _close(fd);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Not a regular file");
+        return NULL;
+    }
+    (void)preallocSize;
+#else
+    struct stat st;
+    int fd = OpenCheckedFd(filePath, ModeToOpenFlags(mode) | O_CLOEXEC, opts, &st);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    if (preallocSize > 0) {
+        PreallocateFd(fd, (long long)st.st_size, preallocSize);
+    }
+#endif
+
+    SafeFileWriter *writer = (SafeFileWriter *)SafeMalloc(sizeof(*writer));
+    if (!writer) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+        return NULL;
+    }
+
+    if (!FdBufferInit(&writer->out, fd, bufferSize)) {
+        FdBufferRelease(&writer->out);
+        SafeFree((void**)&writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+bool SafeFileWriterWrite(SafeFileWriter *writer, const void *data, size_t size) {
+    if (!writer || (!data && size > 0)) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFileWriterWrite");
+        return false;
+    }
+
+    return FdBufferWrite(&writer->out, data, size);
+}
+
+bool SafeFileWriterFlush(SafeFileWriter *writer) {
+    if (!writer) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFileWriterFlush");
+        return false;
+    }
+
+    return !writer->out.failed && FdBufferFlush(&writer->out);
+}
+
+bool SafeFileWriterClose(SafeFileWriter **writerRef) {
+    if (!writerRef || !*writerRef) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFileWriterClose");
+        return false;
+    }
+
+    SafeFileWriter *writer = *writerRef;
+    *writerRef = NULL;
+
+    bool ok = !writer->out.failed && FdBufferFlush(&writer->out);
+    FdBufferRelease(&writer->out);
+    SafeFree((void**)&writer);
+    return ok;
+}
+
+/* ------------------------------------------------------
+   7b) Atomic File Replacement
+   ------------------------------------------------------ */
+
+#define SAFE_ATOMIC_BUFFER_SIZE (64 * 1024)
+
+struct SafeAtomicWriter {
+    SafeFdBuffer out;        /* Temporary file being written */
+#ifdef _WIN32
+    char *targetPath;
+    char *tempPath;
+#else
+    int dirFd;               /* Directory holding target and temp file */
+    char *baseName;          /* Target name relative to dirFd */
+    char tempName[NAME_MAX + 1];  /* Empty while an O_TMPFILE file is still unnamed */
+#endif
+};
+
+/* Unique-enough name for a sibling temp file; collisions are retried by the caller */
+static void MakeTempName(char *out, size_t outSize, const char *baseName) {
+    static THREAD_LOCAL uint64_t counter = 0;
+    uint64_t seed = (uint64_t)time(NULL) ^ ((uint64_t)(uintptr_t)&counter << 16);
+#ifdef _WIN32
+    seed ^= (uint64_t)GetCurrentProcessId() << 32;
+#else
+    seed ^= (uint64_t)getpid() << 32;
+#endif
+    seed += ++counter * 0x9E3779B97F4A7C15ULL;
+    seed ^= seed >> 29;
+    snprintf(out, outSize, ".%s.%012llx.tmp", baseName,
+             (unsigned long long)(seed & 0xFFFFFFFFFFFFULL));
+}
+
+#ifndef _WIN32
+/* Points the writer at path: opens its directory and keeps the final
+   component. The temp file must share the target's directory (and therefore
+   filesystem) for rename to be atomic. */
+static bool AtomicWriterSetTarget(SafeAtomicWriter *writer, const char *path) {
+    const char *slash = strrchr(path, '/');
+    const char *base = slash ? slash + 1 : path;
+    size_t baseLen = strlen(base);
+    if (baseLen == 0 || baseLen > NAME_MAX - 24) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Invalid target file name");
+        return false;
+    }
+
+    char *baseName = (char *)SafeMalloc(baseLen + 1);
+    if (!baseName) {
+        return false;
+    }
+    memcpy(baseName, base, baseLen + 1);
+
+    int dirFd;
+    if (slash) {
+        size_t dirLen = (slash == path) ? 1 : (size_t)(slash - path);
+        char *dir = (char *)SafeMalloc(dirLen + 1);
+        if (!dir) {
+            SafeFree((void**)&baseName);
+            return false;
+        }
+        memcpy(dir, path, dirLen);
+        dirFd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        SafeFree((void**)&dir);
+    } else {
+        dirFd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+    if (dirFd == -1) {
+        SafeFree((void**)&baseName);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to open target directory");
+        return false;
+    }
+
+    if (writer->dirFd != -1) close(writer->dirFd);
+    SafeFree((void**)&writer->baseName);
+    writer->dirFd = dirFd;
+    writer->baseName = baseName;
+    return true;
+}
+
+#ifdef O_TMPFILE
+/* Path through which an O_TMPFILE descriptor can be linked when AT_EMPTY_PATH
+   is not permitted */
+static void TmpFileProcPath(char *out, size_t outSize, int fd) {
+    snprintf(out, outSize, "/proc/self/fd/%d", fd);
+}
+
+/* Gives an unnamed O_TMPFILE inode the name tempName in dirFd */
+static bool LinkTmpFile(int fd, int dirFd, const char *tempName) {
+#ifdef AT_EMPTY_PATH
+    /* Needs no /proc, but older kernels restrict it to CAP_DAC_READ_SEARCH */
+    if (linkat(fd, "", dirFd, tempName, AT_EMPTY_PATH) == 0) {
+        return true;
+    }
+    if (errno == EEXIST) {
+        return false;
+    }
+#endif
+    char procPath[64];
+    TmpFileProcPath(procPath, sizeof(procPath), fd);
+    return linkat(AT_FDCWD, procPath, dirFd, tempName, AT_SYMLINK_FOLLOW) == 0;
+}
+#endif
+#endif
+
+static void AtomicWriterRelease(SafeAtomicWriter *writer, bool removeTemp) {
+    FdBufferRelease(&writer->out);
+#ifdef _WIN32
+    if (removeTemp && writer->tempPath) (void)_unlink(writer->tempPath);
+    SafeFree((void**)&writer->targetPath);
+    SafeFree((void**)&writer->tempPath);
+#else
+    if (removeTemp && writer->tempName[0] != '\0') {
+        (void)unlinkat(writer->dirFd, writer->tempName, 0);
+    }
+    if (writer->dirFd != -1) close(writer->dirFd);
+    SafeFree((void**)&writer->baseName);
+#endif
+    SafeFree((void**)&writer);
+}
+
+SafeAtomicWriter* SafeAtomicWriterOpen(const char *filePath, const SafeFileOpts *opts) {
+    if (!filePath) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeAtomicWriterOpen");
+        return NULL;
+    }
+
+    if (!opts) opts = &g_defaultFileOpts;
+
+    SafeAtomicWriter *writer = (SafeAtomicWriter *)SafeMalloc(sizeof(*writer));
+    if (!writer) {
+        return NULL;
+    }
+    bool bufferOk = FdBufferInit(&writer->out, -1, SAFE_ATOMIC_BUFFER_SIZE);
+
+#ifdef _WIN32
+    size_t pathLen = strlen(filePath);
+    size_t tempSize = pathLen + 40;
+    writer->targetPath = (char *)SafeMalloc(pathLen + 1);
+    writer->tempPath = (char *)SafeMalloc(tempSize);
+    if (!bufferOk || !writer->targetPath || !writer->tempPath) {
+        AtomicWriterRelease(writer, false);
+        return NULL;
+    }
+    memcpy(writer->targetPath, filePath, pathLen + 1);
+
+    struct _stat64 st;
+    if (_stat64(filePath, &st) == 0 && opts->requireRegularFile && !S_ISREG(st.st_mode)) {
+        AtomicWriterRelease(writer, false);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Not a regular file");
+        return NULL;
+    }
+
+    for (int attempt = 0; attempt < 16 && writer->out.fd == -1; attempt++) {
+        char suffix[32];
+        MakeTempName(suffix, sizeof(suffix), "w");
+        snprintf(writer->tempPath, tempSize, "%s%s", filePath, suffix);
+        if (_sopen_s(&writer->out.fd, writer->tempPath, _O_CREAT | _O_EXCL | _O_WRONLY | _O_BINARY,
+                     _SH_DENYRW, _S_IREAD | _S_IWRITE) != 0) {
+            writer->out.fd = -1;
+            if (errno != EEXIST) break;
+        }
+    }
+    if (writer->out.fd == -1) {
+        SafeFree((void**)&writer->tempPath);
+        AtomicWriterRelease(writer, false);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to create temporary file");
+        return NULL;
+    }
+#else
+    writer->dirFd = -1;
+    if (!bufferOk) {
+        AtomicWriterRelease(writer, false);
+        return NULL;
+    }
+
+    if (!AtomicWriterSetTarget(writer, filePath)) {
+        AtomicWriterRelease(writer, false);
+        return NULL;
+    }
+
+    /* Apply the SafeFOpen policy to whatever currently sits at the target */
+    struct stat st;
+    mode_t mode = (mode_t)opts->createMode;
+    if (fstatat(writer->dirFd, writer->baseName, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+        if (S_ISLNK(st.st_mode)) {
+            if (!opts->followSymlinks || fstatat(writer->dirFd, writer->baseName, &st, 0) != 0) {
+                AtomicWriterRelease(writer, false);
+                SetError(SAFEOPS_ERR_FILE_ACCESS, "Target is a symbolic link");
+                return NULL;
+            }
+            /* Replace the file the link points to rather than the link */
+            char *resolved = realpath(filePath, NULL);
+            bool retargeted = resolved && AtomicWriterSetTarget(writer, resolved);
+            free(resolved);
+            if (!retargeted) {
+                AtomicWriterRelease(writer, false);
+                SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to resolve symbolic link target");
+                return NULL;
+            }
+        }
+        if (opts->requireRegularFile && !S_ISREG(st.st_mode)) {
+            AtomicWriterRelease(writer, false);
+            SetError(SAFEOPS_ERR_FILE_ACCESS, "Not a regular file");
+            return NULL;
+        }
+        /* Replacement keeps the existing permissions */
+        mode = st.st_mode & 07777;
+    }
+
+#ifdef O_TMPFILE
+    /* Unnamed file: nothing is visible in the directory until commit */
+    writer->out.fd = openat(writer->dirFd, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, mode);
+    if (writer->out.fd != -1) {
+        /* Commit can always name it through /proc; without /proc fall back to
+           a named temp file now rather than fail after the data is written */
+        char procPath[64];
+        struct stat procSt;
+        TmpFileProcPath(procPath, sizeof(procPath), writer->out.fd);
+        if (stat(procPath, &procSt) != 0) {
+            close(writer->out.fd);
+            writer->out.fd = -1;
+        }
+    }
+#endif
+    for (int attempt = 0; attempt < 16 && writer->out.fd == -1; attempt++) {
+        MakeTempName(writer->tempName, sizeof(writer->tempName), writer->baseName);
+        writer->out.fd = openat(writer->dirFd, writer->tempName,
+                            O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, mode);
+        if (writer->out.fd == -1) {
+            writer->tempName[0] = '\0';
+            if (errno != EEXIST) break;
+        }
+    }
+    if (writer->out.fd == -1) {
+        AtomicWriterRelease(writer, false);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to create temporary file");
+        return NULL;
+    }
+    (void)fchmod(writer->out.fd, mode);
+#endif
+
+    return writer;
+}
+
+bool SafeAtomicWriterWrite(SafeAtomicWriter *writer, const void *data, size_t size) {
+    if (!writer || (!data && size > 0)) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeAtomicWriterWrite");
+        return false;
+    }
+
+    return FdBufferWrite(&writer->out, data, size);
+}
+
+bool SafeAtomicWriterCommit(SafeAtomicWriter **writerRef) {
+    if (!writerRef || !*writerRef) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeAtomicWriterCommit");
+        return false;
+    }
+
+    SafeAtomicWriter *writer = *writerRef;
+    *writerRef = NULL;
+
+    if (writer->out.failed || !FdBufferFlush(&writer->out)) {
+        AtomicWriterRelease(writer, true);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Atomic write failed; target left unchanged");
+        return false;
+    }
+
+#ifdef _WIN32
+    bool ok = _commit(writer->out.fd) == 0;
+    _close(writer->out.fd);
+    writer->out.fd = -1;
+    ok = ok && MoveFileExA(writer->tempPath, writer->targetPath,
+                           MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    /* Data must be durable before the new name can point at it */
+    bool ok = fsync(writer->out.fd) == 0;
+
+    if (ok && writer->tempName[0] == '\0') {
+        /* Give the O_TMPFILE inode a temporary name so it can be renamed */
+        ok = false;
+#ifdef O_TMPFILE
+        for (int attempt = 0; attempt < 16 && !ok; attempt++) {
+            MakeTempName(writer->tempName, sizeof(writer->tempName), writer->baseName);
+            ok = LinkTmpFile(writer->out.fd, writer->dirFd, writer->tempName);
+            if (!ok && errno != EEXIST) break;
+        }
+#endif
+        if (!ok) {
+            writer->tempName[0] = '\0';
+        }
+    }
+
+    ok = ok && renameat(writer->dirFd, writer->tempName, writer->dirFd, writer->baseName) == 0;
+    if (ok) {
+        writer->tempName[0] = '\0';
+        /* Persist the directory entry itself */
+        ok = fsync(writer->dirFd) == 0;
+    }
+#endif
+
+    AtomicWriterRelease(writer, !ok);
+    if (!ok) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to commit atomic write");
+    }
+    return ok;
+}
+
+void SafeAtomicWriterAbort(SafeAtomicWriter **writerRef) {
+    if (!writerRef || !*writerRef) {
+        return;
+    }
+
+    AtomicWriterRelease(*writerRef, true);
+    *writerRef = NULL;
+}
+
+/* ------------------------------------------------------
+   7c) Asynchronous File I/O
+   ------------------------------------------------------ */
+
+#ifndef _WIN32
+
+enum { ASYNC_OP_READ, ASYNC_OP_WRITE };
+enum { ASYNC_SLOT_NONE = -1 };
+
+/* One in-flight request. Slots live in a fixed pool sized to the queue depth
+   and are threaded onto the free / pending / completed lists by index. */
+typedef struct {
+    SafeAsyncCallback callback;
+    void *userData;
+    int fd;
+    int op;
+    struct iovec iov;
+    unsigned long long offset;
+    long long result;
+    int next;
+} SafeAsyncSlot;
+
+struct SafeAsyncIO {
+    SafeAsyncSlot *slots;
+    unsigned int depth;
+    int freeHead;
+    unsigned int inFlight;    /* Prepared, submitted or completed-but-unreaped */
+    unsigned int unsubmitted; /* Prepared since the last SafeAsyncSubmit */
+    bool useRing;
+
+#ifdef SAFEOPS_HAVE_IO_URING
+    int ringFd;
+    void *sqRing;
+    void *cqRing;
+    size_t sqRingSize;
+    size_t cqRingSize;
+    struct io_uring_sqe *sqes;
+    size_t sqesSize;
+    unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+    unsigned *cqHead, *cqTail, *cqMask;
+    struct io_uring_cqe *cqes;
+#endif
+
+    /* Worker-thread fallback */
+    pthread_t *workers;
+    unsigned int workerCount;
+    pthread_mutex_t lock;
+    pthread_cond_t workCond;
+    pthread_cond_t doneCond;
+    int stagedHead, stagedTail;    /* Prepared, not yet submitted */
+    int pendingHead, pendingTail;  /* Submitted, waiting for a worker */
+    int doneHead, doneTail;        /* Finished, waiting for SafeAsyncPoll */
+    unsigned int doneCount;
+    bool stopping;
+};
+
+static void AsyncListPush(SafeAsyncIO *aio, int *head, int *tail, int index) {
+    aio->slots[index].next = ASYNC_SLOT_NONE;
+    if (*tail == ASYNC_SLOT_NONE) {
+        *head = index;
+    } else {
+        aio->slots[*tail].next = index;
+    }
+    *tail = index;
+}
+
+static int AsyncListPop(SafeAsyncIO *aio, int *head, int *tail) {
+    int index = *head;
+    if (index != ASYNC_SLOT_NONE) {
+        *head = aio->slots[index].next;
+        if (*head == ASYNC_SLOT_NONE) {
+            *tail = ASYNC_SLOT_NONE;
+        }
+    }
+    return index;
+}
+
+static long long AsyncPerform(const SafeAsyncSlot *slot) {
+    ssize_t n;
+    do {
+        if (slot->op == ASYNC_OP_READ) {
+            n = pread(slot->fd, slot->iov.iov_base, slot->iov.iov_len, (off_t)slot->offset);
+        } else {
+            n = pwrite(slot->fd, slot->iov.iov_base, slot->iov.iov_len, (off_t)slot->offset);
+        }
+    } while (n < 0 && errno == EINTR);
+    return (n < 0) ? -(long long)errno : (long long)n;
+}
+
+static void* AsyncWorkerMain(void *arg) {
+    SafeAsyncIO *aio = (SafeAsyncIO *)arg;
+
+    pthread_mutex_lock(&aio->lock);
+    for (;;) {
+        while (!aio->stopping && aio->pendingHead == ASYNC_SLOT_NONE) {
+            pthread_cond_wait(&aio->workCond, &aio->lock);
+        }
+        int index = AsyncListPop(aio, &aio->pendingHead, &aio->pendingTail);
+        if (index == ASYNC_SLOT_NONE) {
+            break;  /* Stopping and nothing left to do */
+        }
+
+        pthread_mutex_unlock(&aio->lock);
+        long long result = AsyncPerform(&aio->slots[index]);
+        pthread_mutex_lock(&aio->lock);
+
+        aio->slots[index].result = result;
+        AsyncListPush(aio, &aio->doneHead, &aio->doneTail, index);
+        aio->doneCount++;
+        pthread_cond_broadcast(&aio->doneCond);
+    }
+    pthread_mutex_unlock(&aio->lock);
+    return NULL;
+}
+
+#ifdef SAFEOPS_HAVE_IO_URING
+static bool AsyncRingSetup(SafeAsyncIO *aio) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int)syscall(__NR_io_uring_setup, aio->depth, &params);
+    if (fd < 0) {
+        return false;  /* Old kernel, seccomp or io_uring disabled by sysctl */
+    }
+    aio->ringFd = fd;
+
+    aio->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    aio->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap && aio->cqRingSize > aio->sqRingSize) {
+        aio->sqRingSize = aio->cqRingSize;
+    }
+
+    aio->sqRing = mmap(NULL, aio->sqRingSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (aio->sqRing == MAP_FAILED) {
+        aio->sqRing = NULL;
+        return false;
+    }
+
+    if (singleMap) {
+        aio->cqRing = aio->sqRing;
+    } else {
+        aio->cqRing = mmap(NULL, aio->cqRingSize, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (aio->cqRing == MAP_FAILED) {
+            aio->cqRing = NULL;
+            return false;
+        }
+    }
+
+    aio->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    aio->sqes = (struct io_uring_sqe *)mmap(NULL, aio->sqesSize, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (aio->sqes == MAP_FAILED) {
+        aio->sqes = NULL;
+        return false;
+    }
+
+    char *sq = (char *)aio->sqRing;
+    char *cq = (char *)aio->cqRing;
+    aio->sqHead = (unsigned *)(sq + params.sq_off.head);
+    aio->sqTail = (unsigned *)(sq + params.sq_off.tail);
+    aio->sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+    aio->sqArray = (unsigned *)(sq + params.sq_off.array);
+    aio->cqHead = (unsigned *)(cq + params.cq_off.head);
+    aio->cqTail = (unsigned *)(cq + params.cq_off.tail);
+    aio->cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+    aio->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return true;
+}
+
+static void AsyncRingTeardown(SafeAsyncIO *aio) {
+    if (aio->sqes) munmap(aio->sqes, aio->sqesSize);
+    if (aio->cqRing && aio->cqRing != aio->sqRing) munmap(aio->cqRing, aio->cqRingSize);
+    if (aio->sqRing) munmap(aio->sqRing, aio->sqRingSize);
+    if (aio->ringFd != -1) close(aio->ringFd);
+    aio->sqes = NULL;
+    aio->sqRing = aio->cqRing = NULL;
+    aio->ringFd = -1;
+}
+
+/* Queue one SQE; the kernel sees it after the next io_uring_enter */
+static void AsyncRingPrepare(SafeAsyncIO *aio, int index) {
+    SafeAsyncSlot *slot = &aio->slots[index];
+    unsigned tail = *aio->sqTail;
+    unsigned sqIndex = tail & *aio->sqMask;
+    struct io_uring_sqe *sqe = &aio->sqes[sqIndex];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (slot->op == ASYNC_OP_READ) ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->fd = slot->fd;
+    sqe->off = slot->offset;
+    sqe->addr = (unsigned long long)(uintptr_t)&slot->iov;
+    sqe->len = 1;
+    sqe->user_data = (unsigned long long)index;
+
+    aio->sqArray[sqIndex] = sqIndex;
+    __atomic_store_n(aio->sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/* Invoke callbacks for every completion currently in the CQ ring */
+static unsigned int AsyncRingReap(SafeAsyncIO *aio, bool invokeCallbacks) {
+    unsigned int reaped = 0;
+    unsigned head = *aio->cqHead;
+    unsigned tail = __atomic_load_n(aio->cqTail, __ATOMIC_ACQUIRE);
+
+    while (head != tail) {
+        const struct io_uring_cqe *cqe = &aio->cqes[head & *aio->cqMask];
+        int index = (int)cqe->user_data;
+        long long result = cqe->res;
+        head++;
+        __atomic_store_n(aio->cqHead, head, __ATOMIC_RELEASE);
+
+        SafeAsyncSlot slot = aio->slots[index];
+        aio->slots[index].next = aio->freeHead;
+        aio->freeHead = index;
+        aio->inFlight--;
+        reaped++;
+
+        if (invokeCallbacks && slot.callback) {
+            slot.callback(slot.userData, result);
+        }
+        tail = __atomic_load_n(aio->cqTail, __ATOMIC_ACQUIRE);
+    }
+    return reaped;
+}
+#endif
+
+static void AsyncStopWorkers(SafeAsyncIO *aio) {
+    if (!aio->workers) {
+        return;
+    }
+
+    pthread_mutex_lock(&aio->lock);
+    aio->stopping = true;
+    pthread_cond_broadcast(&aio->workCond);
+    pthread_mutex_unlock(&aio->lock);
+
+    for (unsigned int i = 0; i < aio->workerCount; i++) {
+        pthread_join(aio->workers[i], NULL);
+    }
+    SafeFree((void**)&aio->workers);
+}
+
+SafeAsyncIO* SafeAsyncCreate(unsigned int queueDepth, unsigned int flags) {
+    if (queueDepth == 0 || queueDepth > 4096) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Queue depth must be between 1 and 4096");
+        return NULL;
+    }
+
+    SafeAsyncIO *aio = (SafeAsyncIO *)SafeMalloc(sizeof(*aio));
+    if (!aio) {
+        return NULL;
+    }
+    aio->depth = queueDepth;
+    aio->stagedHead = aio->stagedTail = ASYNC_SLOT_NONE;
+    aio->pendingHead = aio->pendingTail = ASYNC_SLOT_NONE;
+    aio->doneHead = aio->doneTail = ASYNC_SLOT_NONE;
+
+    aio->slots = (SafeAsyncSlot *)SafeMalloc(queueDepth * sizeof(SafeAsyncSlot));
+    if (!aio->slots) {
+        SafeFree((void**)&aio);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < queueDepth; i++) {
+        aio->slots[i].next = (i + 1 < queueDepth) ? (int)(i + 1) : ASYNC_SLOT_NONE;
+    }
+    aio->freeHead = 0;
+
+#ifdef SAFEOPS_HAVE_IO_URING
+    aio->ringFd = -1;
+    if (!(flags & SAFE_ASYNC_FORCE_THREADS)) {
+        aio->useRing = AsyncRingSetup(aio);
+        if (!aio->useRing) {
+            AsyncRingTeardown(aio);
+        }
+    }
+#else
+    (void)flags;
+#endif
+
+    if (!aio->useRing) {
+        pthread_mutex_init(&aio->lock, NULL);
+        pthread_cond_init(&aio->workCond, NULL);
+        pthread_cond_init(&aio->doneCond, NULL);
+
+        unsigned int wanted = (queueDepth < 4) ? queueDepth : 4;
+        aio->workers = (pthread_t *)SafeMalloc(wanted * sizeof(pthread_t));
+        if (aio->workers) {
+            for (; aio->workerCount < wanted; aio->workerCount++) {
+                if (pthread_create(&aio->workers[aio->workerCount], NULL, AsyncWorkerMain, aio) != 0) {
+                    break;
+                }
+            }
+        }
+        if (aio->workerCount == 0) {
+            SafeFree((void**)&aio->workers);
+            pthread_cond_destroy(&aio->doneCond);
+            pthread_cond_destroy(&aio->workCond);
+            pthread_mutex_destroy(&aio->lock);
+            SafeFree((void**)&aio->slots);
+            SafeFree((void**)&aio);
+            SetError(SAFEOPS_ERR_ALLOCATION_FAILED, "Failed to start async I/O workers");
+            return NULL;
+        }
+    }
+
+    return aio;
+}
+
+bool SafeAsyncUsesIoUring(const SafeAsyncIO *aio) {
+    return aio && aio->useRing;
+}
+
+static bool AsyncQueue(SafeAsyncIO *aio, int op, int fd, void *buf, size_t size,
+                       unsigned long long offset, SafeAsyncCallback callback, void *userData) {
+    if (aio->freeHead == ASYNC_SLOT_NONE) {
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Async queue is full; poll for completions first");
+        return false;
+    }
+    if (fd < 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Invalid file descriptor");
+        return false;
+    }
+    if (offset > (unsigned long long)LLONG_MAX || size > (size_t)LLONG_MAX) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Offset or size out of range");
+        return false;
+    }
+
+    int index = aio->freeHead;
+    SafeAsyncSlot *slot = &aio->slots[index];
+    aio->freeHead = slot->next;
+
+    slot->callback = callback;
+    slot->userData = userData;
+    slot->fd = fd;
+    slot->op = op;
+    slot->iov.iov_base = buf;
+    slot->iov.iov_len = size;
+    slot->offset = offset;
+    slot->result = 0;
+    aio->inFlight++;
+    aio->unsubmitted++;
+
+#ifdef SAFEOPS_HAVE_IO_URING
+    if (aio->useRing) {
+        AsyncRingPrepare(aio, index);
+        return true;
+    }
+#endif
+
+    /* Only the submitting thread touches the staged list */
+    slot->next = ASYNC_SLOT_NONE;
+    if (aio->stagedTail == ASYNC_SLOT_NONE) {
+        aio->stagedHead = index;
+    } else {
+        aio->slots[aio->stagedTail].next = index;
+    }
+    aio->stagedTail = index;
+    return true;
+}
+
+bool SafeAsyncRead(SafeAsyncIO *aio, int fd, void *buf, size_t size, unsigned long long offset,
+                   SafeAsyncCallback callback, void *userData) {
+    if (!aio || !buf) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeAsyncRead");
+        return false;
+    }
+
+    return AsyncQueue(aio, ASYNC_OP_READ, fd, buf, size, offset, callback, userData);
+}
+
+bool SafeAsyncWrite(SafeAsyncIO *aio, int fd, const void *buf, size_t size, unsigned long long offset,
+                    SafeAsyncCallback callback, void *userData) {
+    if (!aio || !buf) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeAsyncWrite");
+        return false;
+    }
+
+    return AsyncQueue(aio, ASYNC_OP_WRITE, fd, (void *)buf, size, offset, callback, userData);
+}
+
+bool SafeAsyncSubmit(SafeAsyncIO *aio) {
+    if (!aio) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeAsyncSubmit");
+        return false;
+    }
+
+    if (aio->unsubmitted == 0) {
+        return true;
+    }
+
+#ifdef SAFEOPS_HAVE_IO_URING
+    if (aio->useRing) {
+        /* One syscall hands the whole batch to the kernel */
+        while (aio->unsubmitted > 0) {
+            int n = (int)syscall(__NR_io_uring_enter, aio->ringFd, aio->unsubmitted, 0, 0, NULL, 0);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                /* EBUSY (completion queue full) only clears once completions
+                   are reaped; leave the rest staged for the next submit */
+                SetError(SAFEOPS_ERR_FILE_ACCESS, (errno == EBUSY || errno == EAGAIN)
+                         ? "io_uring busy; poll before submitting again"
+                         : "io_uring submission failed");
+                return false;
+            }
+            aio->unsubmitted -= (unsigned int)n;
+        }
+        return true;
+    }
+#endif
+
+    pthread_mutex_lock(&aio->lock);
+    int index;
+    while ((index = AsyncListPop(aio, &aio->stagedHead, &aio->stagedTail)) != ASYNC_SLOT_NONE) {
+        AsyncListPush(aio, &aio->pendingHead, &aio->pendingTail, index);
+    }
+    aio->unsubmitted = 0;
+    pthread_cond_broadcast(&aio->workCond);
+    pthread_mutex_unlock(&aio->lock);
+    return true;
+}
+
+int SafeAsyncPoll(SafeAsyncIO *aio, unsigned int minComplete) {
+    if (!aio) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeAsyncPoll");
+        return -1;
+    }
+
+    /* Never wait for more than can actually finish */
+    unsigned int waitable = aio->inFlight - aio->unsubmitted;
+    if (minComplete > waitable) {
+        minComplete = waitable;
+    }
+
+#ifdef SAFEOPS_HAVE_IO_URING
+    if (aio->useRing) {
+        unsigned int reaped = AsyncRingReap(aio, true);
+        while (reaped < minComplete) {
+            int n = (int)syscall(__NR_io_uring_enter, aio->ringFd, 0, minComplete - reaped,
+                                 IORING_ENTER_GETEVENTS, NULL, 0);
+            if (n < 0 && errno != EINTR) {
+                SetError(SAFEOPS_ERR_FILE_ACCESS, "io_uring wait failed");
+                return -1;
+            }
+            reaped += AsyncRingReap(aio, true);
+        }
+        return (int)reaped;
+    }
+#endif
+
+    pthread_mutex_lock(&aio->lock);
+    while (aio->doneCount < minComplete) {
+        pthread_cond_wait(&aio->doneCond, &aio->lock);
+    }
+    int done = aio->doneHead;
+    aio->doneHead = aio->doneTail = ASYNC_SLOT_NONE;
+    aio->doneCount = 0;
+    pthread_mutex_unlock(&aio->lock);
+
+    /* Callbacks run on the polling thread, outside the lock */
+    int reaped = 0;
+    while (done != ASYNC_SLOT_NONE) {
+        SafeAsyncSlot slot = aio->slots[done];
+        aio->slots[done].next = aio->freeHead;
+        aio->freeHead = done;
+        aio->inFlight--;
+        reaped++;
+
+        if (slot.callback) {
+            slot.callback(slot.userData, slot.result);
+        }
+        done = slot.next;
+    }
+    return reaped;
+}
+
+void SafeAsyncDestroy(SafeAsyncIO **aioRef) {
+    if (!aioRef || !*aioRef) {
+        return;
+    }
+
+    SafeAsyncIO *aio = *aioRef;
+    *aioRef = NULL;
+
+    /* Buffers may still be in use by the kernel or a worker: finish all
+       submitted requests first. Any the final submit could not hand to the
+       kernel were never started, so only submitted ones are waited for. */
+#ifdef SAFEOPS_HAVE_IO_URING
+    if (aio->useRing) {
+        (void)SafeAsyncSubmit(aio);
+        while (aio->inFlight > aio->unsubmitted) {
+            if (AsyncRingReap(aio, false) == 0) {
+                int n = (int)syscall(__NR_io_uring_enter, aio->ringFd, 0, 1,
+                                     IORING_ENTER_GETEVENTS, NULL, 0);
+                if (n < 0 && errno != EINTR) break;
+            }
+        }
+        AsyncRingTeardown(aio);
+    }
+#endif
+
+    if (!aio->useRing) {
+        AsyncStopWorkers(aio);  /* Workers drain the pending list before exiting */
+        pthread_cond_destroy(&aio->doneCond);
+        pthread_cond_destroy(&aio->workCond);
+        pthread_mutex_destroy(&aio->lock);
+    }
+
+    SafeFree((void**)&aio->slots);
+    SafeFree((void**)&aio);
+}
+
+#else /* _WIN32 */
+
+SafeAsyncIO* SafeAsyncCreate(unsigned int queueDepth, unsigned int flags) {
+    (void)queueDepth;
+    (void)flags;
+    SetError(SAFEOPS_ERR_FILE_ACCESS, "Async file I/O is not supported on this platform");
+    return NULL;
+}
+
+bool SafeAsyncUsesIoUring(const SafeAsyncIO *aio) {
+    (void)aio;
+    return false;
+}
+
+bool SafeAsyncRead(SafeAsyncIO *aio, int fd, void *buf, size_t size, unsigned long long offset,
+                   SafeAsyncCallback callback, void *userData) {
+    (void)aio; (void)fd; (void)buf; (void)size; (void)offset; (void)callback; (void)userData;
+    SetError(SAFEOPS_ERR_FILE_ACCESS, "Async file I/O is not supported on this platform");
+    return false;
+}
+
+bool SafeAsyncWrite(SafeAsyncIO *aio, int fd, const void *buf, size_t size, unsigned long long offset,
+                    SafeAsyncCallback callback, void *userData) {
+    (void)aio; (void)fd; (void)buf; (void)size; (void)offset; (void)callback; (void)userData;
+    SetError(SAFEOPS_ERR_FILE_ACCESS, "Async file I/O is not supported on this platform");
+    return false;
+}
+
+bool SafeAsyncSubmit(SafeAsyncIO *aio) {
+    (void)aio;
+    return false;
+}
+
+int SafeAsyncPoll(SafeAsyncIO *aio, unsigned int minComplete) {
+    (void)aio;
+    (void)minComplete;
+    return -1;
+}
+
+void SafeAsyncDestroy(SafeAsyncIO **aioRef) {
+    (void)aioRef;
+}
+
+#endif
+
+/* ------------------------------------------------------
+   7d) Streaming Line Reader
+   ------------------------------------------------------ */
+
+#define SAFE_LINE_DEFAULT_BUFFER (1024 * 1024)
+#define SAFE_LINE_DEFAULT_MAX    (64 * 1024)
+
+struct SafeLineReader {
+    int fd;                /* -1 when reading from a mapping */
+    const char *data;      /* Internal buffer, or the mapped file */
+    char *buffer;
+    size_t capacity;
+    size_t pos;            /* Start of the next line */
+    size_t end;            /* End of valid data */
+    size_t maxLineLen;
+    bool eof;
+};
+
+static SafeLineReader* LineReaderAlloc(size_t maxLineLen) {
+    SafeLineReader *reader = (SafeLineReader *)SafeMalloc(sizeof(*reader));
+    if (reader) {
+        reader->fd = -1;
+        reader->maxLineLen = maxLineLen ? maxLineLen : SAFE_LINE_DEFAULT_MAX;
+    }
+    return reader;
+}
+
+SafeLineReader* SafeLineReaderOpenFd(int fd, size_t bufferSize, size_t maxLineLen) {
+    if (fd < 0) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Invalid file descriptor");
+        return NULL;
+    }
+
+    SafeLineReader *reader = LineReaderAlloc(maxLineLen);
+    if (!reader) {
+        return NULL;
+    }
+
+    /* A full line plus its newline must always fit after compaction */
+    if (bufferSize == 0) bufferSize = SAFE_LINE_DEFAULT_BUFFER;
+    if (reader->maxLineLen >= SIZE_MAX - 1) {
+        SafeFree((void**)&reader);
+        SetError(SAFEOPS_ERR_OVERFLOW, "Maximum line length too large");
+        return NULL;
+    }
+    if (bufferSize <= reader->maxLineLen) bufferSize = reader->maxLineLen + 1;
+
+    reader->buffer = (char *)SafeMallocUninitialized(bufferSize);
+    if (!reader->buffer) {
+        SafeFree((void**)&reader);
+        return NULL;
+    }
+    reader->data = reader->buffer;
+    reader->capacity = bufferSize;
+    reader->fd = fd;
+
+#if !defined(_WIN32) && defined(POSIX_FADV_SEQUENTIAL)
+    (void)posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return reader;
+}
+
+SafeLineReader* SafeLineReaderOpenView(const SafeFileView *view, size_t maxLineLen) {
+    if (!view || (!view->data && view->size > 0)) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeLineReaderOpenView");
+        return NULL;
+    }
+
+    SafeLineReader *reader = LineReaderAlloc(maxLineLen);
+    if (!reader) {
+        return NULL;
+    }
+
+    reader->data = (const char *)view->data;
+    reader->end = view->size;
+    reader->eof = true;  /* Everything is already "read" */
+    return reader;
+}
+
+/* Moves the partial line to the front and appends one read() worth of data */
+static bool LineReaderRefill(SafeLineReader *reader) {
+    size_t pending = reader->end - reader->pos;
+    if (reader->pos > 0) {
+        memmove(reader->buffer, reader->buffer + reader->pos, pending);
+        reader->pos = 0;
+        reader->end = pending;
+    }
+
+    for (;;) {
 #ifdef _WIN32
-        fclose(fp);
+        size_t room = reader->capacity - reader->end;
+        int n = _read(reader->fd, reader->buffer + reader->end,
+                      (unsigned int)(room > INT_MAX ? INT_MAX : room));
+#else
+        ssize_t n = read(reader->fd, reader->buffer + reader->end, reader->capacity - reader->end);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to read file");
+            return false;
+        }
+        if (n == 0) {
+            reader->eof = true;
+        }
+        reader->end += (size_t)n;
+        return true;
+    }
+}
+
+/* Discards the rest of the current line, through its '\n', reading further
+   as needed; the buffer never has to hold the whole line */
+static bool LineReaderSkipLine(SafeLineReader *reader) {
+    for (;;) {
+        const char *nl = (const char *)memchr(reader->data + reader->pos, '\n', reader->end - reader->pos);
+        if (nl) {
+            reader->pos = (size_t)(nl - reader->data) + 1;
+            return true;
+        }
+        reader->pos = reader->end;
+        if (reader->eof) {
+            return true;
+        }
+        if (!LineReaderRefill(reader)) {
+            return false;
+        }
+    }
+}
+
+bool SafeLineReaderNext(SafeLineReader *reader, SafeStrView *outLine, bool *outEof) {
+    if (!reader || !outLine || !outEof) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeLineReaderNext");
+        return false;
+    }
+
+    size_t scanFrom = reader->pos;
+    for (;;) {
+        /* memchr is the vectorised newline search in every mainstream libc */
+        const char *start = reader->data + reader->pos;
+        const char *nl = (const char *)memchr(reader->data + scanFrom, '\n', reader->end - scanFrom);
+
+        if (nl) {
+            size_t len = (size_t)(nl - start);
+            if (len > reader->maxLineLen) {
+                reader->pos += len + 1;  /* Skip it so the next call moves on */
+                SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Line exceeds maximum length");
+                return false;
+            }
+            outLine->ptr = start;
+            outLine->len = len;
+            reader->pos += len + 1;
+            *outEof = false;
+            return true;
+        }
+
+        size_t pending = reader->end - reader->pos;
+        if (pending > reader->maxLineLen) {
+            if (LineReaderSkipLine(reader)) {
+                SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "Line exceeds maximum length");
+            }
+            return false;
+        }
+
+        if (reader->eof) {
+            /* Final line without a trailing newline */
+            outLine->ptr = pending ? start : NULL;
+            outLine->len = pending;
+            reader->pos = reader->end;
+            *outEof = (pending == 0);
+            return true;
+        }
+
+        /* Only the newly read bytes still need scanning */
+        size_t scanned = pending;
+        if (!LineReaderRefill(reader)) {
+            return false;
+        }
+        scanFrom = reader->pos + scanned;
+    }
+}
+
+void SafeLineReaderClose(SafeLineReader **readerRef) {
+    if (!readerRef || !*readerRef) {
+        return;
+    }
+
+    SafeFree((void**)&(*readerRef)->buffer);
+    SafeFree((void**)readerRef);
+}
+
+/* ------------------------------------------------------
+   7e) Kernel-Side File Copy
+   ------------------------------------------------------ */
+
+#define SAFE_COPY_CHUNK (1024 * 1024)
+
+#ifndef _WIN32
+/* User-space fallback: positional reads and writes through one large buffer */
+static bool CopyRangeBuffered(int srcFd, int dstFd, long long offset, long long size) {
+    char *buffer = (char *)SafeMallocUninitialized(SAFE_COPY_CHUNK);
+    if (!buffer) {
+        return false;
+    }
+
+    bool ok = true;
+    while (ok && offset < size) {
+        size_t want = (size - offset > SAFE_COPY_CHUNK) ? SAFE_COPY_CHUNK : (size_t)(size - offset);
+        ssize_t n = pread(srcFd, buffer, want, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ok = (n == 0);  /* Source shrank underneath us: stop at its new end */
+            break;
+        }
+        for (ssize_t done = 0; ok && done < n;) {
+            ssize_t w = pwrite(dstFd, buffer + done, (size_t)(n - done), (off_t)(offset + done));
+            if (w < 0 && errno == EINTR) continue;
+            ok = (w > 0);
+            if (ok) done += w;
+        }
+        offset += n;
+    }
+
+    SafeFree((void**)&buffer);
+    return ok;
+}
+
+/* Copies srcFd to dstFd, preferring mechanisms that keep data in the kernel
+   (or share extents outright), falling back stage by stage from the offset
+   the previous mechanism reached. */
+static bool CopyFdContents(int srcFd, int dstFd, long long size) {
+#if defined(__linux__) && defined(FICLONE)
+    /* Reflink: O(1) extent sharing on Btrfs, XFS (reflink=1), bcachefs... */
+    if (ioctl(dstFd, FICLONE, srcFd) == 0) {
+        return true;
+    }
+#endif
+
+    long long copied = 0;
+
+#if defined(__linux__) && defined(__NR_copy_file_range)
+    while (copied < size) {
+        loff_t inOff = copied;
+        loff_t outOff = copied;
+        size_t want = (size - copied > (long long)(1 << 30)) ? (size_t)1 << 30 : (size_t)(size - copied);
+        long n = syscall(__NR_copy_file_range, srcFd, &inOff, dstFd, &outOff, want, 0u);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;  /* Unsupported pair (EXDEV, ENOSYS, ...) or EOF: next stage */
+        copied += n;
+    }
+#endif
+
+#ifdef __linux__
+    while (copied < size) {
+        off_t inOff = (off_t)copied;
+        size_t want = (size - copied > (long long)(1 << 30)) ? (size_t)1 << 30 : (size_t)(size - copied);
+        if (lseek(dstFd, (off_t)copied, SEEK_SET) < 0) break;
+        ssize_t n = sendfile(dstFd, srcFd, &inOff, want);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        copied += n;
+    }
+#endif
+
+    return copied >= size || CopyRangeBuffered(srcFd, dstFd, copied, size);
+}
+#endif
+
+bool SafeFileCopy(const char *srcPath, const char *dstPath, const SafeFileOpts *opts) {
+    if (!srcPath || !dstPath) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFileCopy");
+        return false;
+    }
+
+    if (!opts) opts = &g_defaultFileOpts;
+
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(srcPath, &st) != 0 || (opts->requireRegularFile && !S_ISREG(st.st_mode))) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Not a regular file");
+        return false;
+    }
+    if (!CopyFileA(srcPath, dstPath, FALSE)) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to copy file");
+        return false;
+    }
+    return true;
+#else
+    struct stat srcSt, dstSt;
+    int srcFd = OpenCheckedFd(srcPath, O_RDONLY | O_CLOEXEC, opts, &srcSt);
+    if (srcFd == -1) {
+        return false;
+    }
+
+    /* No O_TRUNC yet: copying a file onto itself must not destroy it first */
+    int dstFd = OpenCheckedFd(dstPath, O_WRONLY | O_CREAT | O_CLOEXEC, opts, &dstSt);
+    if (dstFd == -1) {
+        close(srcFd);
+        return false;
+    }
+
+    bool ok = true;
+    if (srcSt.st_dev == dstSt.st_dev && srcSt.st_ino == dstSt.st_ino) {
+        SetError(SAFEOPS_ERR_OVERLAP, "Source and destination are the same file");
+        ok = false;
+    } else if (ftruncate(dstFd, 0) != 0) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to truncate destination");
+        ok = false;
+    } else if (!CopyFdContents(srcFd, dstFd, (long long)srcSt.st_size)) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to copy file contents");
+        ok = false;
+    }
+
+    close(dstFd);
+    close(srcFd);
+    return ok;
+#endif
+}
+
+/* ------------------------------------------------------
+   7f) Open Descriptor Cache
+   ------------------------------------------------------ */
+
+#ifndef _WIN32
+
+struct SafeCachedFile {
+    char *path;
+    size_t pathLen;
+    int dirFd;
+    int fd;
+    uint64_t hash;
+    struct stat st;           /* Identity at open time, used for revalidation */
+    unsigned int refCount;
+    bool stale;               /* Replaced on disk; closed on last release */
+    SafeCachedFile *hashNext;
+    SafeCachedFile *lruPrev;  /* Idle entries only, most recent first */
+    SafeCachedFile *lruNext;
+};
+
+struct SafeFileCache {
+    SafeFileOpts opts;
+    pthread_mutex_t lock;
+    SafeCachedFile **buckets;
+    size_t bucketMask;
+    size_t count;             /* Entries holding an open descriptor */
+    size_t maxFds;
+    SafeCachedFile *lruHead;
+    SafeCachedFile *lruTail;
+};
+
+static uint64_t CacheKeyHash(int dirFd, const char *path, size_t len) {
+    uint64_t h = 1469598103934665603ULL ^ (uint64_t)(unsigned int)dirFd;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)path[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* Same inode, size and modification time as when the descriptor was opened */
+static bool SameFileVersion(const struct stat *a, const struct stat *b) {
+    if (a->st_dev != b->st_dev || a->st_ino != b->st_ino ||
+        a->st_size != b->st_size || a->st_mtime != b->st_mtime) {
+        return false;
+    }
+#ifdef __linux__
+    return a->st_mtim.tv_nsec == b->st_mtim.tv_nsec;
 #else
+    return true;
+#endif
+}
+
+static void CacheLruRemove(SafeFileCache *cache, SafeCachedFile *entry) {
+    if (entry->lruPrev) entry->lruPrev->lruNext = entry->lruNext;
+    else cache->lruHead = entry->lruNext;
+    if (entry->lruNext) entry->lruNext->lruPrev = entry->lruPrev;
+    else cache->lruTail = entry->lruPrev;
+    entry->lruPrev = entry->lruNext = NULL;
+}
+
+static void CacheLruPushFront(SafeFileCache *cache, SafeCachedFile *entry) {
+    entry->lruPrev = NULL;
+    entry->lruNext = cache->lruHead;
+    if (cache->lruHead) cache->lruHead->lruPrev = entry;
+    else cache->lruTail = entry;
+    cache->lruHead = entry;
+}
+
+static SafeCachedFile* CacheFind(SafeFileCache *cache, uint64_t hash, int dirFd,
+                                 const char *path, size_t len) {
+    for (SafeCachedFile *e = cache->buckets[hash & cache->bucketMask]; e; e = e->hashNext) {
+        if (e->hash == hash && e->dirFd == dirFd && e->pathLen == len &&
+            memcmp(e->path, path, len) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void CacheUnlinkHash(SafeFileCache *cache, SafeCachedFile *entry) {
+    SafeCachedFile **link = &cache->buckets[entry->hash & cache->bucketMask];
+    while (*link && *link != entry) {
+        link = &(*link)->hashNext;
+    }
+    if (*link) {
+        *link = entry->hashNext;
+    }
+    entry->hashNext = NULL;
+}
+
+static void CacheEntryFree(SafeFileCache *cache, SafeCachedFile *entry) {
+    close(entry->fd);
+    cache->count--;
+    SafeFree((void**)&entry->path);
+    SafeFree((void**)&entry);
+}
+
+/* Drops an entry from lookup; it is closed now if idle, else on last release */
+static void CacheRetire(SafeFileCache *cache, SafeCachedFile *entry) {
+    CacheUnlinkHash(cache, entry);
+    entry->stale = true;
+    if (entry->refCount == 0) {
+        CacheLruRemove(cache, entry);
+        CacheEntryFree(cache, entry);
+    }
+}
+
+SafeFileCache* SafeFileCacheCreate(size_t maxFds, const SafeFileOpts *opts) {
+    if (maxFds == 0 || maxFds > (SIZE_MAX / 4) / sizeof(SafeCachedFile *)) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Invalid descriptor limit");
+        return NULL;
+    }
+
+    SafeFileCache *cache = (SafeFileCache *)SafeMalloc(sizeof(*cache));
+    if (!cache) {
+        return NULL;
+    }
+
+    /* Load factor <= 0.5 keeps chains short */
+    size_t buckets = 16;
+    while (buckets < maxFds * 2) buckets <<= 1;
+    cache->buckets = (SafeCachedFile **)SafeMalloc(buckets * sizeof(SafeCachedFile *));
+    if (!cache->buckets) {
+        SafeFree((void**)&cache);
+        return NULL;
+    }
+
+    cache->bucketMask = buckets - 1;
+    cache->maxFds = maxFds;
+    cache->opts = opts ? *opts : g_defaultFileOpts;
+    pthread_mutex_init(&cache->lock, NULL);
+    return cache;
+}
+
+SafeCachedFile* SafeFileCacheAcquire(SafeFileCache *cache, int dirFd, const char *relPath) {
+    if (!cache || !relPath) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeFileCacheAcquire");
+        return NULL;
+    }
+
+    size_t len = strlen(relPath);
+    uint64_t hash = CacheKeyHash(dirFd, relPath, len);
+    int statFlags = cache->opts.followSymlinks ? 0 : AT_SYMLINK_NOFOLLOW;
+
+    /* Revalidate with a single stat, outside the lock */
+    struct stat current;
+    bool exists = fstatat(dirFd, relPath, &current, statFlags) == 0;
+
+    pthread_mutex_lock(&cache->lock);
+    SafeCachedFile *entry = CacheFind(cache, hash, dirFd, relPath, len);
+    if (entry && exists && SameFileVersion(&entry->st, &current)) {
+        if (entry->refCount++ == 0) {
+            CacheLruRemove(cache, entry);
+        }
+        pthread_mutex_unlock(&cache->lock);
+        return entry;
+    }
+    if (entry) {
+        CacheRetire(cache, entry);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    if (!exists) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to stat file");
+        return NULL;
+    }
+
+    /* Miss or changed on disk: full validated open */
+    struct stat st;
+    int fd = (dirFd == AT_FDCWD)
+             ? OpenCheckedFd(relPath, O_RDONLY | O_CLOEXEC, &cache->opts, &st)
+             : OpenBeneathFd(dirFd, relPath, O_RDONLY, &cache->opts, &st);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    SafeCachedFile *fresh = (SafeCachedFile *)SafeMalloc(sizeof(*fresh));
+    char *pathCopy = (char *)SafeMallocUninitialized(len + 1);
+    if (!fresh || !pathCopy) {
+        SafeFree((void**)&fresh);
+        SafeFree((void**)&pathCopy);
         close(fd);
-#endif
-        SetError(SAFEOPS_ERR_FILE_ACCESS, "Not a regular file");
         return NULL;
     }
+    memcpy(pathCopy, relPath, len + 1);
+    fresh->path = pathCopy;
+    fresh->pathLen = len;
+    fresh->dirFd = dirFd;
+    fresh->fd = fd;
+    fresh->hash = hash;
+    fresh->st = st;
+    fresh->refCount = 1;
+
+    pthread_mutex_lock(&cache->lock);
+
+    /* Another thread may have opened the same version meanwhile */
+    entry = CacheFind(cache, hash, dirFd, relPath, len);
+    if (entry && SameFileVersion(&entry->st, &st)) {
+        if (entry->refCount++ == 0) {
+            CacheLruRemove(cache, entry);
+        }
+        pthread_mutex_unlock(&cache->lock);
+        close(fd);
+        SafeFree((void**)&fresh->path);
+        SafeFree((void**)&fresh);
+        return entry;
+    }
+    if (entry) {
+        CacheRetire(cache, entry);
+    }
+
+    /* Stay within the descriptor budget by closing idle entries, oldest first */
+    while (cache->count >= cache->maxFds && cache->lruTail) {
+        SafeCachedFile *victim = cache->lruTail;
+        CacheLruRemove(cache, victim);
+        CacheUnlinkHash(cache, victim);
+        CacheEntryFree(cache, victim);
+    }
+    if (cache->count >= cache->maxFds) {
+        pthread_mutex_unlock(&cache->lock);
+        close(fd);
+        SafeFree((void**)&fresh->path);
+        SafeFree((void**)&fresh);
+        SetError(SAFEOPS_ERR_OUT_OF_BOUNDS, "All cached descriptors are in use");
+        return NULL;
+    }
+
+    SafeCachedFile **bucket = &cache->buckets[hash & cache->bucketMask];
+    fresh->hashNext = *bucket;
+    *bucket = fresh;
+    cache->count++;
+    pthread_mutex_unlock(&cache->lock);
+    return fresh;
+}
+
+void SafeFileCacheRelease(SafeFileCache *cache, SafeCachedFile **fileRef) {
+    if (!cache || !fileRef || !*fileRef) {
+        return;
+    }
+
+    SafeCachedFile *entry = *fileRef;
+    *fileRef = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+    if (entry->refCount > 0 && --entry->refCount == 0) {
+        if (entry->stale) {
+            CacheEntryFree(cache, entry);
+        } else {
+            CacheLruPushFront(cache, entry);
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+int SafeCachedFileFd(const SafeCachedFile *file) {
+    return file ? file->fd : -1;
+}
+
+unsigned long long SafeCachedFileSize(const SafeCachedFile *file) {
+    return file ? (unsigned long long)file->st.st_size : 0;
+}
+
+bool SafeCachedFileRead(const SafeCachedFile *file, void *buf, size_t size,
+                        unsigned long long offset, size_t *outRead) {
+    if (!file || !buf || !outRead) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeCachedFileRead");
+        return false;
+    }
+    if (offset > (unsigned long long)LLONG_MAX) {
+        SetError(SAFEOPS_ERR_OVERFLOW, "Offset out of range");
+        return false;
+    }
+
+    ssize_t n;
+    do {
+        n = pread(file->fd, buf, size, (off_t)offset);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to read cached file");
+        return false;
+    }
+    *outRead = (size_t)n;
+    return true;
+}
+
+void SafeFileCacheDestroy(SafeFileCache **cacheRef) {
+    if (!cacheRef || !*cacheRef) {
+        return;
+    }
+
+    SafeFileCache *cache = *cacheRef;
+    *cacheRef = NULL;
+
+    for (size_t i = 0; i <= cache->bucketMask; i++) {
+        SafeCachedFile *e = cache->buckets[i];
+        while (e) {
+            SafeCachedFile *next = e->hashNext;
+            CacheEntryFree(cache, e);
+            e = next;
+        }
+    }
+
+    pthread_mutex_destroy(&cache->lock);
+    SafeFree((void**)&cache->buckets);
+    SafeFree((void**)&cache);
+}
+
+#else /* _WIN32 */
+
+SafeFileCache* SafeFileCacheCreate(size_t maxFds, const SafeFileOpts *opts) {
+    (void)maxFds;
+    (void)opts;
+    SetError(SAFEOPS_ERR_FILE_ACCESS, "File cache is not supported on this platform");
+    return NULL;
+}
+
+SafeCachedFile* SafeFileCacheAcquire(SafeFileCache *cache, int dirFd, const char *relPath) {
+    (void)cache; (void)dirFd; (void)relPath;
+    return NULL;
+}
+
+void SafeFileCacheRelease(SafeFileCache *cache, SafeCachedFile **fileRef) {
+    (void)cache;
+    (void)fileRef;
+}
+
+int SafeCachedFileFd(const SafeCachedFile *file) {
+    (void)file;
+    return -1;
+}
+
+unsigned long long SafeCachedFileSize(const SafeCachedFile *file) {
+    (void)file;
+    return 0;
+}
+
+bool SafeCachedFileRead(const SafeCachedFile *file, void *buf, size_t size,
+                        unsigned long long offset, size_t *outRead) {
+    (void)file; (void)buf; (void)size; (void)offset; (void)outRead;
+    return false;
+}
+
+void SafeFileCacheDestroy(SafeFileCache **cacheRef) {
+    (void)cacheRef;
+}
+
+#endif
+
+/* ------------------------------------------------------
+   7g) Directory Traversal
+   ------------------------------------------------------ */
 
 #ifndef _WIN32
-    fp = fdopen(fd, mode);
-        if (!fp) {
-            close(fd);
-            SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to create FILE stream");
-            return NULL;
+
+#define WALK_DENTS_BUFFER (128 * 1024)  /* Directory entries fetched per syscall */
+
+#ifdef __linux__
+struct SafeLinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#endif
+
+/* A directory waiting to be read. Until opened it holds a reference on its
+   parent, whose descriptor stays open so the child is opened with openat
+   instead of re-resolving the path from the root. */
+typedef struct SafeWalkDir {
+    struct SafeWalkDir *parent;
+    struct SafeWalkDir *next;   /* Work stack link */
+    int fd;
+    unsigned int refs;          /* Own reference while reading + unopened children */
+    unsigned int depth;
+    size_t pathLen;
+    size_t nameOffset;
+    char path[];                /* Relative to the walk root, NUL-terminated */
+} SafeWalkDir;
+
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+} SafeWalkId;
+
+typedef struct {
+    SafeDirWalkCallback callback;
+    void *userData;
+    unsigned int flags;
+    dev_t rootDev;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    SafeWalkDir *stack;         /* LIFO keeps open descriptors near the tree depth */
+    unsigned int active;        /* Workers reading a directory */
+    int stop;                   /* Set by SAFE_WALK_STOP, read atomically */
+    bool failed;
+
+    SafeWalkId *visited;        /* Directory identities, only when following symlinks */
+    size_t visitedMask;
+    size_t visitedCount;
+} SafeDirWalker;
+
+typedef struct {
+    SafeDirWalker *walker;
+    char *dents;
+    char *path;
+    size_t pathCap;
+} SafeWalkWorker;
+
+static bool WalkStopped(SafeDirWalker *w) {
+    return __atomic_load_n(&w->stop, __ATOMIC_RELAXED) != 0;
+}
+
+static void WalkFail(SafeDirWalker *w) {
+    pthread_mutex_lock(&w->lock);
+    w->failed = true;
+    pthread_mutex_unlock(&w->lock);
+}
+
+/* Drops one reference; the descriptor is closed once nothing needs it */
+static void WalkDirRelease(SafeDirWalker *w, SafeWalkDir *dir) {
+    pthread_mutex_lock(&w->lock);
+    bool last = (--dir->refs == 0);
+    pthread_mutex_unlock(&w->lock);
+    if (last) {
+        if (dir->fd != -1) {
+            close(dir->fd);
+        }
+        SafeFree((void**)&dir);
+    }
+}
+
+/* Records a directory identity; false if it was already visited */
+static bool WalkMarkVisited(SafeDirWalker *w, const struct stat *st) {
+    bool added = false;
+    pthread_mutex_lock(&w->lock);
+
+    if (w->visitedCount * 2 >= w->visitedMask + 1) {
+        size_t newMask = w->visitedMask * 2 + 1;
+        SafeWalkId *grown = (SafeWalkId *)SafeMalloc((newMask + 1) * sizeof(SafeWalkId));
+        if (!grown) {
+            w->failed = true;
+            pthread_mutex_unlock(&w->lock);
+            return false;
+        }
+        for (size_t i = 0; i <= w->visitedMask; i++) {
+            SafeWalkId id = w->visited[i];
+            if (id.ino == 0 && id.dev == 0) continue;
+            size_t j = ((size_t)id.ino * 0x9E3779B97F4A7C15ULL) & newMask;
+            while (grown[j].ino != 0 || grown[j].dev != 0) j = (j + 1) & newMask;
+            grown[j] = id;
+        }
+        SafeFree((void**)&w->visited);
+        w->visited = grown;
+        w->visitedMask = newMask;
+    }
+
+    size_t j = ((size_t)st->st_ino * 0x9E3779B97F4A7C15ULL) & w->visitedMask;
+    for (;;) {
+        SafeWalkId *slot = &w->visited[j];
+        if (slot->ino == 0 && slot->dev == 0) {
+            slot->dev = st->st_dev;
+            slot->ino = st->st_ino;
+            w->visitedCount++;
+            added = true;
+            break;
+        }
+        if (slot->dev == st->st_dev && slot->ino == st->st_ino) {
+            break;
+        }
+        j = (j + 1) & w->visitedMask;
+    }
+
+    pthread_mutex_unlock(&w->lock);
+    return added;
+}
+
+/* Checks a freshly opened directory against the walk flags */
+static bool WalkAcceptDir(SafeDirWalker *w, int fd) {
+    if (!(w->flags & (SAFE_WALK_FOLLOW_SYMLINKS | SAFE_WALK_SAME_DEVICE))) {
+        return true;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return false;
+    }
+    if ((w->flags & SAFE_WALK_SAME_DEVICE) && st.st_dev != w->rootDev) {
+        return false;
+    }
+    /* Symlinks can form cycles; read each directory once */
+    return !(w->flags & SAFE_WALK_FOLLOW_SYMLINKS) || WalkMarkVisited(w, &st);
+}
+
+static SafeDirEntryType WalkTypeFromMode(mode_t mode) {
+    if (S_ISREG(mode)) return SAFE_ENTRY_FILE;
+    if (S_ISDIR(mode)) return SAFE_ENTRY_DIR;
+    if (S_ISLNK(mode)) return SAFE_ENTRY_SYMLINK;
+    return SAFE_ENTRY_OTHER;
+}
+
+/* Reports one entry; returns false once the walk has been stopped */
+static bool WalkEntry(SafeWalkWorker *worker, SafeWalkDir *dir, const char *name,
+                      unsigned char dtype, SafeWalkDir **children) {
+    SafeDirWalker *w = worker->walker;
+
+    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+        return true;
+    }
+
+    size_t nameLen = strlen(name);
+    size_t prefix = dir->pathLen ? dir->pathLen + 1 : 0;
+    if (prefix + nameLen + 1 > worker->pathCap) {
+        SafeWalkWorker grown = *worker;
+        grown.pathCap = (prefix + nameLen + 1) * 2;
+        grown.path = (char *)SafeMallocUninitialized(grown.pathCap);
+        if (!grown.path) {
+            WalkFail(w);
+            return true;
+        }
+        memcpy(grown.path, worker->path, prefix);  /* Directory prefix, including the '/' */
+        SafeFree((void**)&worker->path);
+        *worker = grown;
+    }
+    memcpy(worker->path + prefix, name, nameLen + 1);
+
+    /* d_type avoids a stat per entry; only filesystems that leave it unset pay for one */
+    SafeDirEntryType type;
+    switch (dtype) {
+        case DT_REG: type = SAFE_ENTRY_FILE; break;
+        case DT_DIR: type = SAFE_ENTRY_DIR; break;
+        case DT_LNK: type = SAFE_ENTRY_SYMLINK; break;
+        case DT_UNKNOWN: {
+            struct stat st;
+            if (fstatat(dir->fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                return true;  /* Removed since the directory was read */
+            }
+            type = WalkTypeFromMode(st.st_mode);
+            break;
+        }
+        default: type = SAFE_ENTRY_OTHER; break;
+    }
+
+    if (type == SAFE_ENTRY_SYMLINK && (w->flags & SAFE_WALK_FOLLOW_SYMLINKS)) {
+        struct stat st;
+        if (fstatat(dir->fd, name, &st, 0) == 0) {
+            type = WalkTypeFromMode(st.st_mode);
+        }
+    }
+
+    SafeDirEntry entry;
+    entry.dirFd = dir->fd;
+    entry.name = name;
+    entry.relPath = worker->path;
+    entry.relPathLen = prefix + nameLen;
+    entry.type = type;
+    entry.depth = dir->depth;
+
+    SafeWalkAction action = w->callback(w->userData, &entry);
+    if (action == SAFE_WALK_STOP) {
+        __atomic_store_n(&w->stop, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    if (type != SAFE_ENTRY_DIR || action == SAFE_WALK_SKIP) {
+        return true;
+    }
+
+    SafeWalkDir *child = (SafeWalkDir *)SafeMallocUninitialized(sizeof(SafeWalkDir) + entry.relPathLen + 1);
+    if (!child) {
+        WalkFail(w);
+        return true;
+    }
+    memcpy(child->path, worker->path, entry.relPathLen + 1);
+    child->pathLen = entry.relPathLen;
+    child->nameOffset = prefix;
+    child->depth = dir->depth + 1;
+    child->fd = -1;
+    child->refs = 1;
+    child->parent = dir;
+    child->next = *children;
+    *children = child;
+
+    pthread_mutex_lock(&w->lock);
+    dir->refs++;
+    pthread_mutex_unlock(&w->lock);
+    return true;
+}
+
+/* Reads every entry of one directory, collecting subdirectories to descend into */
+static void WalkReadDir(SafeWalkWorker *worker, SafeWalkDir *dir, SafeWalkDir **children) {
+    SafeDirWalker *w = worker->walker;
+
+    if (dir->pathLen + 1 > worker->pathCap) {
+        char *grown = (char *)SafeMallocUninitialized((dir->pathLen + 1) * 2);
+        if (!grown) {
+            WalkFail(w);
+            return;
+        }
+        SafeFree((void**)&worker->path);
+        worker->path = grown;
+        worker->pathCap = (dir->pathLen + 1) * 2;
+    }
+    memcpy(worker->path, dir->path, dir->pathLen);
+    worker->path[dir->pathLen] = '/';
+
+#ifdef __linux__
+    /* getdents64 returns a large batch per syscall, without readdir's DIR state */
+    for (;;) {
+        long n = syscall(SYS_getdents64, dir->fd, worker->dents, WALK_DENTS_BUFFER);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            WalkFail(w);
+            return;
+        }
+        if (n == 0) {
+            return;
+        }
+        for (long off = 0; off < n; ) {
+            struct SafeLinuxDirent64 *d = (struct SafeLinuxDirent64 *)(void *)(worker->dents + off);
+            off += d->d_reclen;
+            if (!WalkEntry(worker, dir, d->d_name, d->d_type, children)) {
+                return;
+            }
+        }
+        if (WalkStopped(w)) {
+            return;
+        }
+    }
+#else
+    int dupFd = dup(dir->fd);
+    DIR *dp = (dupFd == -1) ? NULL : fdopendir(dupFd);
+    if (!dp) {
+        if (dupFd != -1) close(dupFd);
+        WalkFail(w);
+        return;
+    }
+    struct dirent *d;
+    while ((d = readdir(dp)) != NULL) {
+        if (!WalkEntry(worker, dir, d->d_name, d->d_type, children)) {
+            break;
         }
+    }
+    closedir(dp);
 #endif
+}
 
-    return fp;
+/* Opens a queued directory relative to its parent's descriptor and reads it */
+static void WalkProcess(SafeWalkWorker *worker, SafeWalkDir *dir) {
+    SafeDirWalker *w = worker->walker;
+
+    if (dir->fd == -1) {
+        int oflags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+        if (!(w->flags & SAFE_WALK_FOLLOW_SYMLINKS)) {
+            oflags |= O_NOFOLLOW;
+        }
+        int fd;
+        do {
+            fd = openat(dir->parent->fd, dir->path + dir->nameOffset, oflags);
+        } while (fd == -1 && errno == EINTR);
+
+        /* Vanished or swapped for a non-directory since it was listed: not an error */
+        if (fd == -1 && errno != ENOENT && errno != ENOTDIR && errno != ELOOP) {
+            WalkFail(w);
+        }
+        WalkDirRelease(w, dir->parent);
+        dir->parent = NULL;
+
+        if (fd != -1 && !WalkAcceptDir(w, fd)) {
+            close(fd);
+            fd = -1;
+        }
+        if (fd == -1) {
+            WalkDirRelease(w, dir);
+            return;
+        }
+        dir->fd = fd;
+    }
+
+    SafeWalkDir *children = NULL;
+    if (!WalkStopped(w)) {
+        WalkReadDir(worker, dir, &children);
+    }
+
+    /* Reversed so siblings are visited in directory order */
+    SafeWalkDir *ordered = NULL;
+    while (children) {
+        SafeWalkDir *next = children->next;
+        children->next = ordered;
+        ordered = children;
+        children = next;
+    }
+    if (ordered) {
+        SafeWalkDir *last = ordered;
+        while (last->next) last = last->next;
+        pthread_mutex_lock(&w->lock);
+        last->next = w->stack;
+        w->stack = ordered;
+        pthread_cond_broadcast(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+    }
+
+    WalkDirRelease(w, dir);
+}
+
+static void* WalkWorkerMain(void *arg) {
+    SafeWalkWorker *worker = (SafeWalkWorker *)arg;
+    SafeDirWalker *w = worker->walker;
+
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (!w->stack && w->active > 0 && !WalkStopped(w)) {
+            pthread_cond_wait(&w->cond, &w->lock);
+        }
+        if (!w->stack || WalkStopped(w)) {
+            break;  /* Nothing queued and nobody left to produce more */
+        }
+
+        SafeWalkDir *dir = w->stack;
+        w->stack = dir->next;
+        w->active++;
+        pthread_mutex_unlock(&w->lock);
+
+        WalkProcess(worker, dir);
+
+        pthread_mutex_lock(&w->lock);
+        w->active--;
+    }
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+bool SafeDirWalk(const char *rootPath, unsigned int flags, unsigned int threads,
+                 SafeDirWalkCallback callback, void *userData) {
+    if (!rootPath || !callback) {
+        SetError(SAFEOPS_ERR_NULL_POINTER, "NULL pointer in SafeDirWalk");
+        return false;
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    if (threads > 256) {
+        SetError(SAFEOPS_ERR_INVALID_PARAM, "Too many walker threads");
+        return false;
+    }
+
+    int oflags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+    if (!(flags & SAFE_WALK_FOLLOW_SYMLINKS)) {
+        oflags |= O_NOFOLLOW;
+    }
+    int rootFd = open(rootPath, oflags);
+    struct stat rootSt;
+    if (rootFd == -1 || fstat(rootFd, &rootSt) != 0) {
+        if (rootFd != -1) close(rootFd);
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Failed to open directory");
+        return false;
+    }
+
+    SafeDirWalker w;
+    memset(&w, 0, sizeof(w));
+    w.callback = callback;
+    w.userData = userData;
+    w.flags = flags;
+    w.rootDev = rootSt.st_dev;
+
+    SafeWalkWorker *workers = (SafeWalkWorker *)SafeMalloc(threads * sizeof(SafeWalkWorker));
+    pthread_t *tids = (pthread_t *)SafeMalloc(threads * sizeof(pthread_t));
+    SafeWalkDir *root = (SafeWalkDir *)SafeMalloc(sizeof(SafeWalkDir) + 1);
+    bool ok = workers && tids && root;
+    for (unsigned int i = 0; ok && i < threads; i++) {
+        workers[i].walker = &w;
+        workers[i].dents = (char *)SafeMallocUninitialized(WALK_DENTS_BUFFER);
+        ok = workers[i].dents != NULL;
+    }
+    if (ok && (flags & SAFE_WALK_FOLLOW_SYMLINKS)) {
+        w.visitedMask = 63;
+        w.visited = (SafeWalkId *)SafeMalloc(64 * sizeof(SafeWalkId));
+        ok = w.visited && WalkMarkVisited(&w, &rootSt);
+    }
+    if (!ok) {
+        for (unsigned int i = 0; workers && i < threads; i++) {
+            SafeFree((void**)&workers[i].dents);
+        }
+        SafeFree((void**)&w.visited);
+        SafeFree((void**)&root);
+        SafeFree((void**)&tids);
+        SafeFree((void**)&workers);
+        close(rootFd);
+        return false;
+    }
+
+    root->fd = rootFd;
+    root->refs = 1;
+    w.stack = root;
+    pthread_mutex_init(&w.lock, NULL);
+    pthread_cond_init(&w.cond, NULL);
+
+    /* The calling thread is worker 0; the rest pick up queued subdirectories */
+    unsigned int started = 1;
+    for (unsigned int i = 1; i < threads; i++) {
+        if (pthread_create(&tids[i], NULL, WalkWorkerMain, &workers[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+    WalkWorkerMain(&workers[0]);
+    for (unsigned int i = 1; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    /* After a stop, drop directories that were queued but never read */
+    while (w.stack) {
+        SafeWalkDir *dir = w.stack;
+        w.stack = dir->next;
+        if (dir->parent) {
+            WalkDirRelease(&w, dir->parent);
+        }
+        WalkDirRelease(&w, dir);
+    }
+
+    for (unsigned int i = 0; i < threads; i++) {
+        SafeFree((void**)&workers[i].dents);
+        SafeFree((void**)&workers[i].path);
+    }
+    pthread_cond_destroy(&w.cond);
+    pthread_mutex_destroy(&w.lock);
+    SafeFree((void**)&w.visited);
+    SafeFree((void**)&tids);
+    SafeFree((void**)&workers);
+
+    if (w.failed) {
+        SetError(SAFEOPS_ERR_FILE_ACCESS, "Some directories could not be read");
+        return false;
+    }
+    return true;
+}
+
+#else /* _WIN32 */
+
+bool SafeDirWalk(const char *rootPath, unsigned int flags, unsigned int threads,
+                 SafeDirWalkCallback callback, void *userData) {
+    (void)rootPath; (void)flags; (void)threads; (void)callback; (void)userData;
+    SetError(SAFEOPS_ERR_FILE_ACCESS, "Directory walking is not supported on this platform");
+    return false;
 }
 
+#endif
+
 /* ------------------------------------------------------
    8) Additional Helpers
    ------------------------------------------------------ */
@@ -1,7 +1,16 @@
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "SafeOps.h"
+#ifdef _WIN32
+#include <io.h>
+#define close _close
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 // Function prototypes for our tests
 void test_memory_operations(void);
@@ -11,6 +20,8 @@ void test_array_operations(void);
 void test_arithmetic_operations(void);
 void test_file_operations(void);
 void pause_console(void);
+void async_read_done(void *userData, long long result);
+SafeWalkAction walk_find_writer(void *userData, const SafeDirEntry *entry);
 
 int main() {
     int choice;
@@ -110,6 +121,23 @@ void test_memory_operations(void) {
             printf("FAIL: Typed memory free failed\n");
         }
     }
+
+    // Test constant-time comparisons
+    printf("\nTesting SafeMemEqualCT / SafeStrEqualCT...\n");
+    unsigned char macA[40], macB[40];
+    for (int i = 0; i < 40; i++) {
+        macA[i] = macB[i] = (unsigned char)(i * 7);
+    }
+    bool sameOk = SafeMemEqualCT(macA, macB, sizeof(macA));
+    macB[39] ^= 0x01;
+    bool diffOk = !SafeMemEqualCT(macA, macB, sizeof(macA));
+    if (sameOk && diffOk &&
+        SafeStrEqualCT("secret-token", "secret-token", 64) &&
+        !SafeStrEqualCT("secret-token", "secret-toke", 64)) {
+        printf("SUCCESS: Constant-time comparisons correct\n");
+    } else {
+        printf("FAIL: Constant-time comparison mismatch\n");
+    }
     printf("\n");
 }
 
@@ -153,6 +181,147 @@ void test_string_operations(void) {
     } else {
         printf("FAIL: String replacement failed\n");
     }
+
+    // Test count-limited copy and concatenation
+    printf("\nTesting SafeStrNCopy / SafeStrNCat...\n");
+    char small[8];
+    if (SafeStrNCopy(small, sizeof(small), "abcdefghij", 4) &&
+        SafeStrNCat(small, sizeof(small), "xyz", 2) && strcmp(small, "abcdxy") == 0 &&
+        !SafeStrNCat(small, sizeof(small), "xyz", 3)) {
+        printf("SUCCESS: Copied and appended within limits: '%s'\n", small);
+    } else {
+        printf("FAIL: Count-limited copy incorrect\n");
+    }
+
+    // Test non-mutating splitter
+    printf("\nTesting SafeStrSplit...\n");
+    const char *record = "id,name,,city;zip";
+    SafeStrSplitter splitter;
+    SafeStrToken token;
+    size_t fields = 0, emptyFields = 0, lastOffset = 0;
+    if (SafeStrSplitInit(&splitter, record, strlen(record), ",;", 2, SAFE_SPLIT_CHARSET)) {
+        while (SafeStrSplitNext(&splitter, &token)) {
+            fields++;
+            if (token.len == 0) emptyFields++;
+            lastOffset = token.offset;
+        }
+    }
+    if (fields == 5 && emptyFields == 1 && strcmp(record + lastOffset, "zip") == 0) {
+        printf("SUCCESS: Split into %zu fields without copying\n", fields);
+    } else {
+        printf("FAIL: Splitter produced unexpected tokens\n");
+    }
+
+    // Test bounded comparisons
+    printf("\nTesting SafeStrCompare / SafeStrCaseCompare...\n");
+    int cmp1, cmp2;
+    if (SafeStrCompare("apple", "apricot", 16, &cmp1) &&
+        SafeStrCaseCompare("Content-Length", "content-length", 64, &cmp2) &&
+        cmp1 < 0 && cmp2 == 0 &&
+        SafeMemCaseEqual("HOST", 4, "host", 4) &&
+        !SafeMemEqual("host", 4, "hosts", 5)) {
+        printf("SUCCESS: Comparisons returned expected ordering\n");
+    } else {
+        printf("FAIL: Comparison results incorrect\n");
+    }
+
+    // Test SafeSnprintf and compiled formats
+    printf("\nTesting SafeSnprintf / SafeFormatRun...\n");
+    char line[32];
+    char shortLine[8];
+    SafeFormat *logFormat = SafeFormatCompile("id=%d user=%s hex=%x %5.1f%%");
+    if (logFormat &&
+        SafeFormatRun(logFormat, line, sizeof(line), -42, "bob", 255u, 99.5) == 29 &&
+        strcmp(line, "id=-42 user=bob hex=ff  99.5%") == 0 &&
+        SafeSnprintf(shortLine, sizeof(shortLine), "%s", "too long") == -1 &&
+        SafeOpsGetLastError() == SAFEOPS_ERR_OUT_OF_BOUNDS && shortLine[0] == '\0' &&
+        SafeFormatCompile("%d%n") == NULL && SafeOpsGetLastError() == SAFEOPS_ERR_INVALID_PARAM) {
+        printf("SUCCESS: Formatted '%s', truncation and %%n rejected\n", line);
+    } else {
+        printf("FAIL: Formatting results incorrect\n");
+    }
+    SafeFormatFree(&logFormat);
+
+    // Test literal-format dispatch and its non-variadic targets
+    printf("\nTesting SafeSnprintfInt / format dispatch...\n");
+    unsigned long long mask = 0xbeefULL;
+    const char *word = "word";
+    if (SafeSnprintf(line, sizeof(line), "%d", -17) == 3 && strcmp(line, "-17") == 0 &&
+        SafeSnprintf(line, sizeof(line), "%llx", mask) == 4 && strcmp(line, "beef") == 0 &&
+        SafeSnprintf(line, sizeof(line), "%s", word) == 4 && strcmp(line, "word") == 0 &&
+        SafeSnprintfStr(line, sizeof(line), NULL) == 6 && strcmp(line, "(null)") == 0 &&
+        SafeSnprintfUInt(shortLine, sizeof(shortLine), 123456789ULL) == -1 && shortLine[0] == '\0' &&
+        SafeSnprintfInt(line, sizeof(line), -5) == 2 && strcmp(line, "-5") == 0) {
+        printf("SUCCESS: Single-conversion formats produced identical output\n");
+    } else {
+        printf("FAIL: Format dispatch results incorrect\n");
+    }
+
+    // Test binary-to-text encoders and strict decoders
+    printf("\nTesting SafeBase64Encode / SafeHexDecode...\n");
+    unsigned char bytes[16];
+    size_t codedLen = 0;
+    bool encodeOk = SafeBase64Encode(line, sizeof(line), "hello", 5, SAFE_BASE64_DEFAULT, &codedLen) &&
+                    strcmp(line, "aGVsbG8=") == 0 &&
+                    SafeBase64Encode(line, sizeof(line), "\xfb\xff", 2, SAFE_BASE64_URL | SAFE_BASE64_NO_PAD, &codedLen) &&
+                    strcmp(line, "-_8") == 0 &&
+                    SafeBase32Encode(line, sizeof(line), "foo", 3, SAFE_BASE32_DEFAULT, &codedLen) &&
+                    strcmp(line, "MZXW6===") == 0;
+    bool decodeOk = SafeBase64Decode(bytes, sizeof(bytes), "aGVsbG8=", 8, SAFE_BASE64_DEFAULT, &codedLen) &&
+                    codedLen == 5 && memcmp(bytes, "hello", 5) == 0 &&
+                    SafeHexDecode(bytes, sizeof(bytes), "DEADbeef", 8, &codedLen) &&
+                    codedLen == 4 && bytes[0] == 0xDE && bytes[3] == 0xEF;
+    bool rejectOk = !SafeBase64Decode(bytes, sizeof(bytes), "aGVsbG8", 7, SAFE_BASE64_DEFAULT, &codedLen) &&
+                    SafeOpsGetLastError() == SAFEOPS_ERR_INVALID_ENCODING &&
+                    !SafeHexDecode(bytes, sizeof(bytes), "12x4", 4, &codedLen) && codedLen == 2;
+    if (encodeOk && decodeOk && rejectOk) {
+        printf("SUCCESS: Encoded, decoded and rejected malformed input\n");
+    } else {
+        printf("FAIL: Encoding results incorrect\n");
+    }
+
+    // Test escaping, including the size-only pass and a short destination
+    printf("\nTesting SafeEscapeJson / SafeEscapeHtml / SafeEscapeUrl...\n");
+    const char *untrusted = "a\"b<c>\n&d e";
+    size_t untrustedLen = strlen(untrusted);
+    size_t escapedLen = 0;
+    bool jsonOk = SafeEscapeJson(NULL, 0, untrusted, untrustedLen, &escapedLen) && escapedLen == 13 &&
+                  SafeEscapeJson(line, sizeof(line), untrusted, untrustedLen, &escapedLen) &&
+                  strcmp(line, "a\\\"b<c>\\n&d e") == 0;
+    bool htmlOk = SafeEscapeHtml(line, sizeof(line), untrusted, untrustedLen, &escapedLen) &&
+                  strcmp(line, "a&quot;b&lt;c&gt;\n&amp;d e") == 0;
+    bool urlOk = SafeEscapeUrl(line, sizeof(line), untrusted, untrustedLen, &escapedLen) &&
+                 strcmp(line, "a%22b%3Cc%3E%0A%26d%20e") == 0 &&
+                 !SafeEscapeUrl(shortLine, sizeof(shortLine), untrusted, untrustedLen, &escapedLen) &&
+                 shortLine[0] == '\0' && escapedLen == 23;
+    if (jsonOk && htmlOk && urlOk) {
+        printf("SUCCESS: Escaped for JSON, HTML and URLs\n");
+    } else {
+        printf("FAIL: Escaping results incorrect\n");
+    }
+
+    // Test interning: equal strings share one copy and id
+    printf("\nTesting SafeStrIntern...\n");
+    SafeInternTable *interned = SafeStrInternCreate(0, SAFE_INTERN_CONCURRENT);
+    char key[8];
+    strcpy(key, "host");
+    uint32_t hostId = 0;
+    uint32_t statusId = 0;
+    uint32_t againId = 0;
+    size_t keyLen = 0;
+    const char *host = SafeStrIntern(interned, key, 4, &hostId);
+    const char *status = SafeStrIntern(interned, "status", 6, &statusId);
+    strcpy(key, "hostX");
+    const char *again = SafeStrIntern(interned, key, 4, &againId);
+    if (host && status && host == again && hostId == againId && hostId != statusId &&
+        strcmp(host, "host") == 0 && SafeStrInternGet(interned, statusId, &keyLen) == status &&
+        keyLen == 6 && SafeStrInternCount(interned) == 2 &&
+        SafeStrInternFind(interned, "path", 4, NULL) == NULL) {
+        printf("SUCCESS: Interned strings deduplicated\n");
+    } else {
+        printf("FAIL: Interning results incorrect\n");
+    }
+    SafeStrInternDestroy(&interned);
     printf("\n");
 }
 
@@ -179,6 +348,52 @@ void test_wide_string_operations(void) {
     } else {
         printf("FAIL: Wide string concatenation failed\n");
     }
+
+    // Test unbounded-source wide copy and concatenation
+    printf("\nTesting SafeWStrCopy / SafeWStrCat...\n");
+    wchar_t wsmall[8];
+    size_t wlen = 0;
+    if (SafeWStrCopy(wsmall, 8, L"wide") && SafeWStrCat(wsmall, 8, L"str") &&
+        SafeWStrLen(wsmall, 8, &wlen) && wlen == 7 &&
+        !SafeWStrCat(wsmall, 8, L"!") && wcscmp(wsmall, L"widestr") == 0) {
+        printf("SUCCESS: Wide copy/concatenation bounded correctly\n");
+    } else {
+        printf("FAIL: Wide copy/concatenation incorrect\n");
+    }
+
+    // Test UTF-8 transcoding
+    printf("\nTesting SafeUtf8ToWide / SafeWideToUtf8...\n");
+    const char *utf8 = "caf\xC3\xA9 \xF0\x9F\x98\x80";
+    size_t needed = 0, wideLen = 0, utf8Len = 0, badOffset = 0;
+    wchar_t wide[16];
+    char roundTrip[32];
+    if (SafeUtf8ToWide(utf8, strlen(utf8), NULL, 0, &needed) &&
+        SafeUtf8ToWide(utf8, strlen(utf8), wide, 16, &wideLen) && wideLen == needed &&
+        SafeWideToUtf8(wide, wideLen, roundTrip, sizeof(roundTrip), &utf8Len) &&
+        strcmp(roundTrip, utf8) == 0 &&
+        !SafeUtf8ToWide("ab\xC0\xAF", 4, wide, 16, &badOffset) && badOffset == 2 &&
+        SafeOpsGetLastError() == SAFEOPS_ERR_INVALID_ENCODING) {
+        printf("SUCCESS: Round trip exact, overlong sequence rejected\n");
+    } else {
+        printf("FAIL: UTF-8 transcoding incorrect\n");
+    }
+
+    // Test UTF-8 validation
+    printf("\nTesting SafeUtf8Validate...\n");
+    char body[100];
+    memset(body, 'x', sizeof(body));
+    memcpy(body + 10, "\xE2\x82\xAC", 3);
+    size_t codePoints = 0, invalidAt = 0;
+    bool wellFormed = SafeUtf8CountCodePoints(body, sizeof(body), &codePoints, NULL);
+    body[70] = (char)0xED;  /* Lead byte of a surrogate */
+    body[71] = (char)0xA0;
+    body[72] = (char)0x80;
+    if (wellFormed && codePoints == 98 &&
+        !SafeUtf8Validate(body, sizeof(body), &invalidAt) && invalidAt == 70) {
+        printf("SUCCESS: Counted code points, surrogate located at offset %zu\n", invalidAt);
+    } else {
+        printf("FAIL: UTF-8 validation incorrect\n");
+    }
     printf("\n");
 }
 
@@ -246,6 +461,38 @@ void test_arithmetic_operations(void) {
     } else {
         printf("FAIL: Cast failed\n");
     }
+
+    // Test text-to-number parsing
+    printf("\nTesting SafeParseInt64 / SafeParseDouble...\n");
+    int64_t parsed = 0;
+    int32_t parsed32 = 0;
+    double parsedDouble = 0.0;
+    if (SafeParseInt64("-9223372036854775808", 20, &parsed) && parsed == INT64_MIN &&
+        !SafeParseInt32("2147483648", 10, &parsed32) && SafeOpsGetLastError() == SAFEOPS_ERR_OVERFLOW &&
+        !SafeParseInt64("12a", 3, &parsed) && SafeOpsGetLastError() == SAFEOPS_ERR_INVALID_PARAM &&
+        SafeParseDouble("1234.5e-1", 9, &parsedDouble) && parsedDouble == 123.45) {
+        printf("SUCCESS: Parsed %lld and %g, range and syntax errors caught\n",
+               (long long)parsed, parsedDouble);
+    } else {
+        printf("FAIL: Numeric parsing incorrect\n");
+    }
+
+    // Test number-to-text formatting
+    printf("\nTesting SafeFmtInt / SafeFmtDouble...\n");
+    char numBuf[32];
+    char tinyBuf[4];
+    size_t written = 0;
+    if (SafeFmtInt(numBuf, sizeof(numBuf), INT64_MIN, &written) &&
+        strcmp(numBuf, "-9223372036854775808") == 0 && written == 20 &&
+        SafeFmtHex(numBuf, sizeof(numBuf), 0xdeadbeefULL, &written) && strcmp(numBuf, "deadbeef") == 0 &&
+        !SafeFmtUInt(tinyBuf, sizeof(tinyBuf), 12345, &written) && written == 5 && tinyBuf[0] == '\0' &&
+        SafeFmtDouble(numBuf, sizeof(numBuf), 0.1 + 0.2, &written) && strcmp(numBuf, "0.30000000000000004") == 0 &&
+        SafeParseDouble(numBuf, written, &parsedDouble) && parsedDouble == 0.1 + 0.2 &&
+        SafeFmtDouble(numBuf, sizeof(numBuf), 5e-324, &written) && strcmp(numBuf, "5e-324") == 0) {
+        printf("SUCCESS: Formatted shortest round-trip numbers, truncation caught\n");
+    } else {
+        printf("FAIL: Number formatting incorrect\n");
+    }
     printf("\n");
 }
 
@@ -282,12 +529,294 @@ void test_file_operations(void) {
         } else {
             printf("FAIL: Could not open file for reading\n");
         }
+
+        // Test memory-mapped reading
+        printf("\nTesting SafeFMap...\n");
+        SafeFileView view;
+        if (SafeFMap("test.txt", &opts, SAFE_MAP_SEQUENTIAL, &view)) {
+            if (view.size == 13 && memcmp(view.data, "Test content\n", 13) == 0) {
+                printf("SUCCESS: Mapped %zu bytes\n", view.size);
+            } else {
+                printf("FAIL: Mapped content mismatch\n");
+            }
+            SafeFUnmap(&view);
+        } else {
+            printf("FAIL: Could not map file\n");
+        }
     } else {
         printf("FAIL: Could not open file for writing\n");
     }
+
+    // Test atomic replacement
+    printf("\nTesting SafeAtomicWriter...\n");
+    SafeAtomicWriter *writer = SafeAtomicWriterOpen("test.txt", &opts);
+    if (writer && SafeAtomicWriterWrite(writer, "Replaced\n", 9) &&
+        SafeAtomicWriterCommit(&writer) && writer == NULL) {
+        file = SafeFOpen("test.txt", "r", &opts);
+        char buffer[100] = {0};
+        if (file && fgets(buffer, sizeof(buffer), file) && strcmp(buffer, "Replaced\n") == 0) {
+            printf("SUCCESS: File replaced atomically\n");
+        } else {
+            printf("FAIL: Replaced content mismatch\n");
+        }
+        if (file) fclose(file);
+    } else {
+        SafeAtomicWriterAbort(&writer);
+        printf("FAIL: Atomic write failed\n");
+    }
+
+    // Test large-buffer writer
+    printf("\nTesting SafeFileWriter...\n");
+    SafeFileWriter *fastWriter = SafeFileWriterOpen("test_writer.txt", "w", &opts, 0, 4096);
+    bool writesOk = fastWriter != NULL;
+    for (int i = 0; writesOk && i < 1000; i++) {
+        writesOk = SafeFileWriterWrite(fastWriter, "0123456789\n", 11);
+    }
+    if (writesOk && SafeFileWriterClose(&fastWriter) && fastWriter == NULL) {
+        SafeFileView written;
+        if (SafeFMap("test_writer.txt", &opts, SAFE_MAP_NORMAL, &written) && written.size == 11000) {
+            printf("SUCCESS: Buffered writer produced %zu bytes\n", written.size);
+        } else {
+            printf("FAIL: Buffered writer size mismatch\n");
+        }
+        SafeFUnmap(&written);
+    } else {
+        if (fastWriter) SafeFileWriterClose(&fastWriter);
+        printf("FAIL: Buffered writer failed\n");
+    }
+
+    // Test asynchronous reads
+    printf("\nTesting SafeAsyncRead...\n");
+    int fd = SafeFOpenFd("test_writer.txt", "r", &opts);
+    SafeAsyncIO *aio = SafeAsyncCreate(8, SAFE_ASYNC_DEFAULT);
+    if (fd != -1 && aio) {
+        char chunks[4][11];
+        long long totalRead = 0;
+        for (int i = 0; i < 4; i++) {
+            SafeAsyncRead(aio, fd, chunks[i], 11, (unsigned long long)i * 11, async_read_done, &totalRead);
+        }
+        SafeAsyncSubmit(aio);
+        int completed = 0;
+        while (completed < 4) {
+            int n = SafeAsyncPoll(aio, 4 - completed);
+            if (n < 0) break;
+            completed += n;
+        }
+        if (completed == 4 && totalRead == 44 && memcmp(chunks[3], "0123456789\n", 11) == 0) {
+            printf("SUCCESS: 4 batched reads completed (%s)\n",
+                   SafeAsyncUsesIoUring(aio) ? "io_uring" : "worker threads");
+        } else {
+            printf("FAIL: Async reads incomplete\n");
+        }
+    } else {
+        printf("FAIL: Could not set up async I/O\n");
+    }
+    SafeAsyncDestroy(&aio);
+    if (fd != -1) close(fd);
+
+    // Test zero-copy line reading
+    printf("\nTesting SafeLineReader...\n");
+    fd = SafeFOpenFd("test_writer.txt", "r", &opts);
+    SafeLineReader *lines = (fd != -1) ? SafeLineReaderOpenFd(fd, 64, 32) : NULL;
+    if (lines) {
+        SafeStrView line;
+        bool eof = false;
+        size_t lineCount = 0;
+        bool linesOk = true;
+        while (linesOk && SafeLineReaderNext(lines, &line, &eof) && !eof) {
+            linesOk = line.len == 10 && memcmp(line.ptr, "0123456789", 10) == 0;
+            lineCount++;
+        }
+        if (linesOk && eof && lineCount == 1000) {
+            printf("SUCCESS: Read %zu lines across buffer boundaries\n", lineCount);
+        } else {
+            printf("FAIL: Line reader returned wrong lines\n");
+        }
+        SafeLineReaderClose(&lines);
+    } else {
+        printf("FAIL: Could not create line reader\n");
+    }
+    if (fd != -1) close(fd);
+
+    // An over-long line is reported and skipped, not retried forever
+    FILE *longFile = fopen("test_lines.txt", "w");
+    if (longFile) {
+        fputs("short\n", longFile);
+        for (int i = 0; i < 200; i++) fputc('x', longFile);
+        fputs("\nafter\n", longFile);
+        fclose(longFile);
+    }
+    fd = SafeFOpenFd("test_lines.txt", "r", &opts);
+    lines = (fd != -1) ? SafeLineReaderOpenFd(fd, 64, 16) : NULL;
+    if (lines) {
+        SafeStrView line;
+        bool eof = false;
+        bool firstOk = SafeLineReaderNext(lines, &line, &eof) && line.len == 5;
+        bool longSkipped = !SafeLineReaderNext(lines, &line, &eof) &&
+                           SafeOpsGetLastError() == SAFEOPS_ERR_OUT_OF_BOUNDS;
+        bool afterOk = SafeLineReaderNext(lines, &line, &eof) && !eof &&
+                       line.len == 5 && memcmp(line.ptr, "after", 5) == 0;
+        if (firstOk && longSkipped && afterOk && SafeLineReaderNext(lines, &line, &eof) && eof) {
+            printf("SUCCESS: Over-long line rejected and skipped\n");
+        } else {
+            printf("FAIL: Over-long line not skipped\n");
+        }
+        SafeLineReaderClose(&lines);
+    } else {
+        printf("FAIL: Could not create line reader\n");
+    }
+    if (fd != -1) close(fd);
+    remove("test_lines.txt");
+
+    // Test extended open options
+    printf("\nTesting SafeFOpenEx...\n");
+    SafeFileOptsEx exOpts = SAFE_FILE_OPTS_EX_INIT;
+    exOpts.base = opts;
+    exOpts.advice = SAFE_ADVICE_SEQUENTIAL;
+    exOpts.readaheadBytes = 64 * 1024;
+    FILE *hinted = SafeFOpenEx("test_writer.txt", "r", &exOpts);
+    exOpts.directIO = true;
+    FILE *directStream = SafeFOpenEx("test_writer.txt", "r", &exOpts);
+    if (hinted && !directStream) {
+        printf("SUCCESS: Hints applied, direct I/O on a FILE* rejected\n");
+    } else {
+        printf("FAIL: Extended options not validated\n");
+    }
+    if (hinted) SafeFClose(&hinted);
+    if (directStream) SafeFClose(&directStream);
+
+    // Test kernel-side copy
+    printf("\nTesting SafeFileCopy...\n");
+    if (SafeFileCopy("test_writer.txt", "test_copy.txt", &opts)) {
+        SafeFileView original = { 0 }, copy = { 0 };
+        bool same = SafeFMap("test_writer.txt", &opts, SAFE_MAP_NORMAL, &original) &&
+                    SafeFMap("test_copy.txt", &opts, SAFE_MAP_NORMAL, &copy) &&
+                    SafeMemEqual(original.data, original.size, copy.data, copy.size);
+        printf(same ? "SUCCESS: Copy matches source\n" : "FAIL: Copy differs from source\n");
+        SafeFUnmap(&original);
+        SafeFUnmap(&copy);
+    } else {
+        printf("FAIL: File copy failed\n");
+    }
+    if (!SafeFileCopy("test_copy.txt", "test_copy.txt", &opts)) {
+        printf("SUCCESS: Copy onto itself rejected\n");
+    } else {
+        printf("FAIL: Self-copy not detected\n");
+    }
+    remove("test_copy.txt");
+
+#ifndef _WIN32
+    // Test directory-confined open
+    printf("\nTesting SafeFOpenAt...\n");
+    int dirFd = open(".", O_RDONLY);
+    FILE *inside = SafeFOpenAt(dirFd, "test_writer.txt", "r", &opts);
+    FILE *outside = SafeFOpenAt(dirFd, "../test_writer.txt", "r", &opts);
+    if (inside && !outside) {
+        printf("SUCCESS: Opened inside directory, escape rejected\n");
+    } else {
+        printf("FAIL: Directory confinement incorrect\n");
+    }
+    if (inside) fclose(inside);
+    if (outside) fclose(outside);
+
+    // Test descriptor cache
+    printf("\nTesting SafeFileCache...\n");
+    SafeFileCache *cache = SafeFileCacheCreate(4, &opts);
+    SafeCachedFile *first = cache ? SafeFileCacheAcquire(cache, dirFd, "test_writer.txt") : NULL;
+    SafeCachedFile *second = cache ? SafeFileCacheAcquire(cache, dirFd, "test_writer.txt") : NULL;
+    char head[10];
+    size_t headLen = 0;
+    if (first && first == second && SafeCachedFileSize(first) == 11000 &&
+        SafeCachedFileRead(first, head, sizeof(head), 11, &headLen) && headLen == 10 &&
+        memcmp(head, "0123456789", 10) == 0) {
+        printf("SUCCESS: Repeated open served from cache\n");
+    } else {
+        printf("FAIL: File cache returned unexpected handle\n");
+    }
+    SafeFileCacheRelease(cache, &first);
+    SafeFileCacheRelease(cache, &second);
+    SafeFileCacheDestroy(&cache);
+    if (dirFd != -1) close(dirFd);
+
+    // Test directory walk
+    printf("\nTesting SafeDirWalk...\n");
+    int writerFound = 0;
+    if (SafeDirWalk(".", SAFE_WALK_DEFAULT, 1, walk_find_writer, &writerFound) && writerFound == 1) {
+        printf("SUCCESS: Walk reported the file once\n");
+    } else {
+        printf("FAIL: Directory walk missed the file\n");
+    }
+
+    // Test buffered printf, capturing stdout in a temp file
+    printf("\nTesting SafePrintfSetBuffered...\n");
+    fflush(stdout);
+    int savedStdout = dup(STDOUT_FILENO);
+    int captureFd = open("test_printf.txt", O_RDWR | O_CREAT | O_TRUNC, 0600);
+    char captured[64] = { 0 };
+    bool heldBack = false;
+    bool flushedIdle = false;
+    if (captureFd != -1 && savedStdout != -1 && dup2(captureFd, STDOUT_FILENO) != -1) {
+        SafePrintfSetBuffered(true, 0, 60000);
+        SafePrintf("%s=%d\n", "alpha", 1);
+        SafePrintf("partial");
+        heldBack = (lseek(captureFd, 0, SEEK_END) == 0);
+        SafePrintfFlush();
+        // A complete line must go out within the interval with no further prints
+        SafePrintfSetBuffered(true, 0, 20);
+        SafePrintf("beta\n");
+        time_t started = time(NULL);
+        while (!flushedIdle && time(NULL) - started < 3) {
+            flushedIdle = (lseek(captureFd, 0, SEEK_END) > 15);
+        }
+        SafePrintfSetBuffered(false, 0, 0);
+        dup2(savedStdout, STDOUT_FILENO);
+        if (lseek(captureFd, 0, SEEK_SET) != 0 ||
+            read(captureFd, captured, sizeof(captured) - 1) < 0) captured[0] = '\0';
+    }
+    if (savedStdout != -1) close(savedStdout);
+    if (captureFd != -1) close(captureFd);
+    remove("test_printf.txt");
+    if (heldBack && flushedIdle && strcmp(captured, "alpha=1\npartialbeta\n") == 0) {
+        printf("SUCCESS: Output held per thread until flushed\n");
+    } else {
+        printf("FAIL: Buffered printf output incorrect\n");
+    }
+#endif
+
+    // Test secure deletion
+    printf("\nTesting SafeSecureUnlink...\n");
+    SafeFileOpts wipeOpts = opts;
+    wipeOpts.secureDelete = true;
+    if (SafeSecureUnlink("test_writer.txt", &wipeOpts)) {
+        FILE *gone = SafeFOpen("test_writer.txt", "r", &opts);
+        if (!gone) {
+            printf("SUCCESS: File overwritten and removed\n");
+        } else {
+            printf("FAIL: File still present after secure delete\n");
+            SafeFClose(&gone);
+        }
+    } else {
+        printf("FAIL: Secure delete failed\n");
+    }
     printf("\n");
 }
 
+void async_read_done(void *userData, long long result) {
+    if (result > 0) {
+        *(long long *)userData += result;
+    }
+}
+
+SafeWalkAction walk_find_writer(void *userData, const SafeDirEntry *entry) {
+    if (entry->type == SAFE_ENTRY_DIR) {
+        return SAFE_WALK_SKIP;
+    }
+    if (entry->type == SAFE_ENTRY_FILE && strcmp(entry->relPath, "test_writer.txt") == 0) {
+        (*(int *)userData)++;
+    }
+    return SAFE_WALK_CONTINUE;
+}
+
 void pause_console(void) {
     printf("\nPress Enter to continue...");
     while (getchar() != '\n'); // Clear any remaining characters